@@ -0,0 +1,241 @@
+// #################################################################
+//
+// Host (Linux) stand-in for IAR <msp430f149.h>
+//
+// Every peripheral register is routed through sim_reg8()/sim_reg16()
+// so the MSP430 model in sim_msp430.c can see port edges, USART
+// TXBUF/RXBUF traffic and Timer_A accesses, and can charge CPU time
+// for each access. Only the registers and bits used by device_lib are
+// provided.
+//
+// #################################################################
+#ifndef _MSP430F149_SIM_H_
+#define _MSP430F149_SIM_H_
+
+//-----------------------------------------------------------------
+// Register IDs
+//-----------------------------------------------------------------
+enum sim_reg8_id {
+  SIM_P1IN, SIM_P1OUT, SIM_P1DIR, SIM_P1IFG, SIM_P1IES, SIM_P1IE, SIM_P1SEL,
+  SIM_P2IN, SIM_P2OUT, SIM_P2DIR, SIM_P2IFG, SIM_P2IES, SIM_P2IE, SIM_P2SEL,
+  SIM_P3IN, SIM_P3OUT, SIM_P3DIR, SIM_P3SEL,
+  SIM_P4IN, SIM_P4OUT, SIM_P4DIR, SIM_P4SEL,
+  SIM_P5IN, SIM_P5OUT, SIM_P5DIR, SIM_P5SEL,
+  SIM_P6IN, SIM_P6OUT, SIM_P6DIR, SIM_P6SEL,
+  SIM_IE1, SIM_IE2, SIM_IFG1, SIM_IFG2, SIM_ME1, SIM_ME2,
+  SIM_U0CTL, SIM_U0TCTL, SIM_U0RCTL, SIM_U0BR0, SIM_U0BR1, SIM_U0MCTL, SIM_RXBUF0,
+  SIM_U1CTL, SIM_U1TCTL, SIM_U1RCTL, SIM_U1BR0, SIM_U1BR1, SIM_U1MCTL, SIM_RXBUF1,
+  SIM_DCOCTL, SIM_BCSCTL1, SIM_BCSCTL2,
+  SIM_REG8_MAX
+};
+
+enum sim_reg16_id {
+  SIM_TXBUF0, SIM_TXBUF1,   // 16-bit backing so every write is visible
+  SIM_TACTL, SIM_TAR, SIM_TAIV,
+  SIM_CCTL0, SIM_CCTL1, SIM_CCTL2,
+  SIM_CCR0, SIM_CCR1, SIM_CCR2,
+  SIM_WDTCTL,
+  SIM_REG16_MAX
+};
+
+volatile unsigned char  *sim_reg8(int id);
+volatile unsigned short *sim_reg16(int id);
+
+//-----------------------------------------------------------------
+// Ports
+//-----------------------------------------------------------------
+#define P1IN      (*sim_reg8(SIM_P1IN))
+#define P1OUT     (*sim_reg8(SIM_P1OUT))
+#define P1DIR     (*sim_reg8(SIM_P1DIR))
+#define P1IFG     (*sim_reg8(SIM_P1IFG))
+#define P1IES     (*sim_reg8(SIM_P1IES))
+#define P1IE      (*sim_reg8(SIM_P1IE))
+#define P1SEL     (*sim_reg8(SIM_P1SEL))
+#define P2IN      (*sim_reg8(SIM_P2IN))
+#define P2OUT     (*sim_reg8(SIM_P2OUT))
+#define P2DIR     (*sim_reg8(SIM_P2DIR))
+#define P2IFG     (*sim_reg8(SIM_P2IFG))
+#define P2IES     (*sim_reg8(SIM_P2IES))
+#define P2IE      (*sim_reg8(SIM_P2IE))
+#define P2SEL     (*sim_reg8(SIM_P2SEL))
+#define P3IN      (*sim_reg8(SIM_P3IN))
+#define P3OUT     (*sim_reg8(SIM_P3OUT))
+#define P3DIR     (*sim_reg8(SIM_P3DIR))
+#define P3SEL     (*sim_reg8(SIM_P3SEL))
+#define P4IN      (*sim_reg8(SIM_P4IN))
+#define P4OUT     (*sim_reg8(SIM_P4OUT))
+#define P4DIR     (*sim_reg8(SIM_P4DIR))
+#define P4SEL     (*sim_reg8(SIM_P4SEL))
+#define P5IN      (*sim_reg8(SIM_P5IN))
+#define P5OUT     (*sim_reg8(SIM_P5OUT))
+#define P5DIR     (*sim_reg8(SIM_P5DIR))
+#define P5SEL     (*sim_reg8(SIM_P5SEL))
+#define P6IN      (*sim_reg8(SIM_P6IN))
+#define P6OUT     (*sim_reg8(SIM_P6OUT))
+#define P6DIR     (*sim_reg8(SIM_P6DIR))
+#define P6SEL     (*sim_reg8(SIM_P6SEL))
+
+#define BIT0      0x01
+#define BIT1      0x02
+#define BIT2      0x04
+#define BIT3      0x08
+#define BIT4      0x10
+#define BIT5      0x20
+#define BIT6      0x40
+#define BIT7      0x80
+
+//-----------------------------------------------------------------
+// Special function registers
+//-----------------------------------------------------------------
+#define IE1       (*sim_reg8(SIM_IE1))
+#define IE2       (*sim_reg8(SIM_IE2))
+#define IFG1      (*sim_reg8(SIM_IFG1))
+#define IFG2      (*sim_reg8(SIM_IFG2))
+#define ME1       (*sim_reg8(SIM_ME1))
+#define ME2       (*sim_reg8(SIM_ME2))
+
+#define URXIE0    0x40
+#define UTXIE0    0x80
+#define URXIFG0   0x40
+#define UTXIFG0   0x80
+#define URXE0     0x40
+#define UTXE0     0x80
+#define USPIE0    0x40
+#define URXIE1    0x10
+#define UTXIE1    0x20
+#define URXIFG1   0x10
+#define UTXIFG1   0x20
+#define URXE1     0x10
+#define UTXE1     0x20
+#define USPIE1    0x10
+
+//-----------------------------------------------------------------
+// USART0/1 (SPI mode)
+//-----------------------------------------------------------------
+#define U0CTL     (*sim_reg8(SIM_U0CTL))
+#define U0TCTL    (*sim_reg8(SIM_U0TCTL))
+#define U0RCTL    (*sim_reg8(SIM_U0RCTL))
+#define U0BR0     (*sim_reg8(SIM_U0BR0))
+#define U0BR1     (*sim_reg8(SIM_U0BR1))
+#define U0MCTL    (*sim_reg8(SIM_U0MCTL))
+#define RXBUF0    (*sim_reg8(SIM_RXBUF0))
+#define TXBUF0    (*sim_reg16(SIM_TXBUF0))
+#define U1CTL     (*sim_reg8(SIM_U1CTL))
+#define U1TCTL    (*sim_reg8(SIM_U1TCTL))
+#define U1RCTL    (*sim_reg8(SIM_U1RCTL))
+#define U1BR0     (*sim_reg8(SIM_U1BR0))
+#define U1BR1     (*sim_reg8(SIM_U1BR1))
+#define U1MCTL    (*sim_reg8(SIM_U1MCTL))
+#define RXBUF1    (*sim_reg8(SIM_RXBUF1))
+#define TXBUF1    (*sim_reg16(SIM_TXBUF1))
+
+#define SWRST     0x01
+#define MM        0x02
+#define SYNC      0x04
+#define LISTEN    0x08
+#define CHAR      0x10
+#define TXEPT     0x01
+#define STC       0x02
+#define SSEL0     0x10
+#define SSEL1     0x20
+#define CKPL      0x40
+#define CKPH      0x80
+#define OE        0x20
+
+//-----------------------------------------------------------------
+// Basic clock
+//-----------------------------------------------------------------
+#define DCOCTL    (*sim_reg8(SIM_DCOCTL))
+#define BCSCTL1   (*sim_reg8(SIM_BCSCTL1))
+#define BCSCTL2   (*sim_reg8(SIM_BCSCTL2))
+
+//-----------------------------------------------------------------
+// Timer_A3
+//-----------------------------------------------------------------
+#define TACTL     (*sim_reg16(SIM_TACTL))
+#define TAR       (*sim_reg16(SIM_TAR))
+#define TAIV      (*sim_reg16(SIM_TAIV))
+#define CCTL0     (*sim_reg16(SIM_CCTL0))
+#define CCTL1     (*sim_reg16(SIM_CCTL1))
+#define CCTL2     (*sim_reg16(SIM_CCTL2))
+#define CCR0      (*sim_reg16(SIM_CCR0))
+#define CCR1      (*sim_reg16(SIM_CCR1))
+#define CCR2      (*sim_reg16(SIM_CCR2))
+
+#define TAIFG     0x0001
+#define TAIE      0x0002
+#define TACLR     0x0004
+#define MC_0      0x0000
+#define MC_1      0x0010
+#define MC_2      0x0020
+#define MC_3      0x0030
+#define ID_0      0x0000
+#define ID_1      0x0040
+#define ID_2      0x0080
+#define ID_3      0x00C0
+#define TASSEL_0  0x0000
+#define TASSEL_1  0x0100
+#define TASSEL_2  0x0200
+#define TASSEL_3  0x0300
+
+#define CCIFG     0x0001
+#define COV       0x0002
+#define OUT       0x0004
+#define CCI       0x0008
+#define CCIE      0x0010
+#define CAP       0x0100
+#define SCS       0x0800
+
+//-----------------------------------------------------------------
+// Watchdog
+//-----------------------------------------------------------------
+#define WDTCTL    (*sim_reg16(SIM_WDTCTL))
+#define WDTPW     0x5A00
+#define WDTHOLD   0x0080
+
+//-----------------------------------------------------------------
+// Status register & IAR intrinsics
+//-----------------------------------------------------------------
+#define GIE       0x0008
+#define CPUOFF    0x0010
+#define OSCOFF    0x0020
+#define SCG0      0x0040
+#define SCG1      0x0080
+#define LPM0_bits (CPUOFF)
+#define LPM1_bits (SCG0+CPUOFF)
+#define LPM2_bits (SCG1+CPUOFF)
+#define LPM3_bits (SCG1+SCG0+CPUOFF)
+#define LPM4_bits (SCG1+SCG0+OSCOFF+CPUOFF)
+
+void           sim_bis_sr(unsigned short bits);
+void           sim_bic_sr(unsigned short bits);
+void           sim_bic_sr_on_exit(unsigned short bits);
+unsigned short sim_get_sr(void);
+
+#define _BIS_SR(x)                    sim_bis_sr(x)
+#define _BIC_SR(x)                    sim_bic_sr(x)
+#define _BIC_SR_IRQ(x)                sim_bic_sr_on_exit(x)
+#define __bis_SR_register(x)          sim_bis_sr(x)
+#define __bic_SR_register(x)          sim_bic_sr(x)
+#define __bic_SR_register_on_exit(x)  sim_bic_sr_on_exit(x)
+#define __get_SR_register()           sim_get_sr()
+#define _EINT()                       sim_bis_sr(GIE)
+#define _DINT()                       sim_bic_sr(GIE)
+#define __enable_interrupt()          sim_bis_sr(GIE)
+#define __disable_interrupt()         sim_bic_sr(GIE)
+#define _NOP()                        ((void)0)
+#define __no_operation()              ((void)0)
+
+typedef unsigned short istate_t;
+#define __get_interrupt_state()       (sim_get_sr() & GIE)
+#define __set_interrupt_state(s)      ((s) ? sim_bis_sr(GIE) : sim_bic_sr(GIE))
+
+// ISRs become plain functions; sim_msp430.c binds them by name
+#define __interrupt
+
+// charge 'n' CPU cycles of register-free code (e.g. delay loops),
+// device code calls it as SIM_CYCLES() (no-op on the target, timer_lib.h)
+void sim_cycles(unsigned long n);
+#define SIM_CYCLES(n)                 sim_cycles(n)
+
+#endif // _MSP430F149_SIM_H_
@@ -0,0 +1,40 @@
+// #################################################################
+//
+// Host simulation shared state (board model <-> radio model <-> main)
+//
+// #################################################################
+#ifndef _SIM_H_
+#define _SIM_H_
+
+#include "sim_nrf24.h"
+
+// MCLK = SMCLK = DCO default (~800kHz), which is what CCR0_BASE=800
+// per 1ms tick in timer_lib.h actually runs at on the F149 board
+#ifndef SIM_MCLK_HZ
+ #define SIM_MCLK_HZ        800000UL
+#endif
+
+// average CPU cycles charged per peripheral register access; code
+// between accesses is not modelled instruction by instruction.
+// 12 reproduces the register bound GPIO row of the rf24_lib.h table
+#ifndef SIM_ACCESS_CYCLES
+ #define SIM_ACCESS_CYCLES  12
+#endif
+
+#define SIM_US(us)          ((sim_time_t)(us) * SIM_MCLK_HZ / 1000000UL)
+
+extern sim_time_t sim_now;          // MCLK cycles since reset
+extern sim_time_t sim_end;          // stop time
+extern sim_time_t sim_awake;        // cycles with CPU on
+extern unsigned   sim_loss;         // packet/ACK loss per mille
+extern unsigned   sim_min_br;       // USART UxBR below: MISO bits corrupted (long wiring)
+extern unsigned   sim_fault_ms;     // mean msec between radio upsets, 0: none
+extern unsigned long sim_isr_cnt;
+
+void     sim_reset(void);           // power-on reset of board & radios
+void     sim_seed(unsigned long s);
+unsigned sim_random(unsigned range);
+void     sim_ports_update(void);    // IRQ pins changed
+void     sim_finish(void);          // report & exit, in sim_main.c
+
+#endif // _SIM_H_
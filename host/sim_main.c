@@ -0,0 +1,190 @@
+// #################################################################
+//
+// Host benchmark driver: runs main.c against the board + radio model
+// for a fixed virtual time and reports the delivered packet rate
+// and SPI cost per packet.
+//
+// usage: <sim> [-t seconds] [-l loss_per_mille] [-s seed] [-f fault_msec] [-q]
+//   -f  radio upsets every ~fault_msec (sim_nrf24.c)
+//   -q  one table row (see "make bench")
+//
+// #################################################################
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "sim.h"
+#include "../device_lib/rf24_ring.h"
+#include "../device_lib/rf24_stats.h"
+#include "../device_lib/rf24_recov.h"
+#include "../device_lib/sched_lib.h"
+
+#ifndef SIM_CFG
+ #define SIM_CFG  "default"
+#endif
+
+// main() of main.c, renamed by the Makefile
+int rf24_app_main(void);
+
+// application rate as shown on the LEDs (max over 1 sec windows)
+extern unsigned char tx_pkt_rate __attribute__((weak));
+
+// TX_TMOUT/RX_TMOUT keep-alive recoveries of main.c
+extern unsigned char to_a_cnt __attribute__((weak)), to_b_cnt __attribute__((weak));
+
+// PRX packet ring of main.c (absent in TX only configs)
+extern rx_ring_t Rx2_Ring __attribute__((weak));
+
+// rf24_stats.c counters (absent with -DNO_RF24_STATS)
+extern rf24_stats_t rf24_stats[2] __attribute__((weak));
+
+// rf24_recov.c tiers (absent with -DNO_RF24_RECOV)
+extern rf24_recov_t rf24_recov[2] __attribute__((weak));
+
+// SCK divider of rf24_spi.c (absent in GPIO configs)
+extern unsigned char spi_get_div(int nrf24) __attribute__((weak));
+
+#ifdef SCHED_STATS
+// sched_lib.c task statistics (absent with -DNO_SCHED_STATS)
+extern sched_task_t *sched_task(unsigned char prio) __attribute__((weak));
+extern unsigned long sched_span(void) __attribute__((weak));
+extern unsigned long sched_idle(void) __attribute__((weak));
+#endif
+
+static void stats_report(int n)
+{
+  rf24_stats_t *st = &rf24_stats[n];
+  rf24_pipe_stats_t *ps;
+  int p;
+
+  for (p = 0; p < 6; p++) {
+    ps = &st->pipe[p];
+    if (!(ps->tx | ps->rx)) continue;
+    printf("  %c pipe %d        : tx %lu ack %lu max_rt %lu retx %lu lost %lu, %lu B, ack_pl %lu B, rx %lu %lu B\n",
+           'A' + n, p, ps->tx, ps->ack, ps->max_rt, ps->retx, ps->lost, ps->tx_bytes,
+           ps->ack_pl_bytes, ps->rx, ps->rx_bytes);
+  }
+  if (st->lat_cnt) {
+    printf("  %c TX->ACK usec    : min %lu avg %lu max %lu, log2 hist",
+           'A' + n, st->lat_min, rf24_stats_lat_avg(n), st->lat_max);
+    for (p = 0; p < RF24_LAT_BINS; p++) printf(" %u", st->lat_hist[p]);
+    printf("\n");
+  }
+}
+
+static int quiet;
+
+static double per(unsigned long n, unsigned long d)
+{
+  return d ? (double)n / d : 0.0;
+}
+
+static void recov_report(int n)
+{
+  static const char *tier[RCV_TIERS] = { "clear", "flush", "ce", "pwr", "init" };
+  rf24_recov_t *rc = &rf24_recov[n];
+  int t;
+
+  printf("  %c tiers         :", 'A' + n);
+  for (t = 0; t < RCV_TIERS; t++) {
+    printf(" %s %lu", tier[t], rc->runs[t]);
+    if (rc->runs[t]) printf(" (%.0f SMCLK)", per(rc->cycles[t], rc->runs[t]));
+  }
+  printf("\n");
+}
+
+#ifdef SCHED_STATS
+static void sched_report(void)
+{
+  unsigned long span = sched_span();
+  sched_task_t *t;
+  int p;
+
+  printf("Scheduler         : idle %.1f%% of %lu SMCLK\n", 100.0 * per(sched_idle(), span), span);
+  for (p = 0; p < SCHED_TASKS; p++) {
+    t = sched_task(p);
+    if (!t->fn) continue;
+    printf("  task %d          : %lu runs, %lu SMCLK (%.1f%%), %.1f per run\n", p,
+           t->runs, t->cycles, 100.0 * per(t->cycles, span), per(t->cycles, t->runs));
+  }
+}
+#endif
+
+void sim_finish(void)
+{
+  struct nrf24 *a = &nrf[0], *b = &nrf[1];
+  double secs = (double)sim_now / SIM_MCLK_HZ;
+  unsigned long pkts = a->st.tx_ds;
+  unsigned app = &tx_pkt_rate ? tx_pkt_rate : 0;
+
+  sim_end = (sim_time_t)-1;     // report reads registers (get_stamp()), no finish again
+
+  if (quiet) {
+    printf("%-22s %7.1f %5u %7.1f %7.1f %6.1f %6.1f %6lu %6lu %5.1f%%\n", SIM_CFG,
+           pkts / secs, app,
+           per(a->st.spi_bytes, pkts), per(b->st.spi_bytes, pkts),
+           per(a->st.spi_frames, pkts), per(b->st.spi_frames, pkts),
+           a->st.retransmits, a->st.max_rt,
+           100.0 * sim_awake / (sim_now ? sim_now : 1));
+  } else {
+    printf("config            : %s\n", SIM_CFG);
+    printf("virtual time      : %.3f s, CPU awake %.1f%%, %lu ISRs\n", secs,
+           100.0 * sim_awake / (sim_now ? sim_now : 1), sim_isr_cnt);
+    printf("PTX delivered     : %lu pkt, %.1f pkt/s (app tx_pkt_rate %u)\n", pkts, pkts / secs, app);
+    printf("PTX on air        : %lu pkt, %lu retransmits, %lu MAX_RT, %lu ACK payloads\n",
+           a->st.tx_air, a->st.retransmits, a->st.max_rt, a->st.ack_pl_rx);
+    printf("PRX received      : %lu pkt, %lu dup, %lu overflow, %lu ACK payloads\n",
+           b->st.rx_pkts, b->st.rx_dup, b->st.rx_overflow, b->st.ack_pl_tx);
+    printf("SPI bytes/packet  : A %.1f, B %.1f\n", per(a->st.spi_bytes, pkts), per(b->st.spi_bytes, pkts));
+    printf("SPI frames/packet : A %.1f, B %.1f\n", per(a->st.spi_frames, pkts), per(b->st.spi_frames, pkts));
+    if (&spi_get_div)
+      printf("SPI SCK divider   : A %u, B %u\n", spi_get_div(0), spi_get_div(1));
+    printf("KA timeouts       : A %u, B %u\n", &to_a_cnt ? to_a_cnt : 0, &to_b_cnt ? to_b_cnt : 0);
+    if (sim_fault_ms)
+      printf("Radio upsets      : A %lu, B %lu\n", a->st.faults, b->st.faults);
+    if (&rf24_recov) {
+      printf("Recovery          :\n");
+      recov_report(0);
+      recov_report(1);
+    }
+    if (&Rx2_Ring)
+      printf("PRX RX ring       : %u of %u slots high-water, %u full\n",
+             Rx2_Ring.hwm, RX_RING_SIZE, Rx2_Ring.ovf);
+#ifdef SCHED_STATS
+    if (&sched_task)
+      sched_report();
+#endif
+    if (&rf24_stats) {
+      printf("RF24 statistics   :\n");
+      stats_report(0);
+      stats_report(1);
+    }
+  }
+  fflush(stdout);
+  exit(0);
+}
+
+int main(int argc, char **argv)
+{
+  double secs = 10.0;
+  int c;
+
+  while ((c = getopt(argc, argv, "t:l:s:b:f:q")) != -1) {
+    switch (c) {
+    case 't': secs = atof(optarg); break;
+    case 'l': sim_loss = atoi(optarg); break;
+    case 's': sim_seed(strtoul(optarg, NULL, 0)); break;
+    case 'b': sim_min_br = atoi(optarg); break;
+    case 'f': sim_fault_ms = atoi(optarg); break;
+    case 'q': quiet = 1; break;
+    default:
+      fprintf(stderr, "usage: %s [-t seconds] [-l loss_per_mille] [-s seed] [-b min_UxBR] [-f fault_msec] [-q]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  sim_reset();
+  sim_end = (sim_time_t)(secs * SIM_MCLK_HZ);
+  rf24_app_main();
+  sim_finish();
+  return 0;
+}
@@ -0,0 +1,644 @@
+// #################################################################
+//
+// MSP430F149 board model for the host build
+//
+// - every register access through <msp430f149.h> lands in
+//   sim_reg8()/sim_reg16(): pending writes of the previous access are
+//   applied (port edges, TXBUF loads, Timer_A control), then the
+//   clock advances by SIM_ACCESS_CYCLES and due interrupts are taken
+// - P1..P6 with the two nRF24L01+ wired as on the test board:
+//     RF24L01_A: CE P4.4, CSN P4.5, SCK P5.3, MOSI P5.1, MISO P5.2, IRQ P1.4
+//     RF24L01_B: CE P4.6, CSN P3.0, SCK P3.3, MOSI P3.1, MISO P3.2, IRQ P1.7
+//   SCK/MOSI/MISO go to USART1 (A) / USART0 (B) when PxSEL is set,
+//   otherwise they are bit-banged pins sampled on SCK edges
+// - USART0/1 SPI master: TXBUF + shift register, 8*UxBR cycles/byte
+// - Timer_A3 in continuous or up mode from SMCLK or ACLK (32768Hz),
+//   CCR0~2 compare, TAIFG, TAIV
+// - SR with GIE and LPMx; ISRs bound by name (weak symbols)
+//
+// #################################################################
+#include <stdio.h>
+#include <string.h>
+#include "msp430f149.h"
+#include "sim.h"
+
+sim_time_t sim_now;
+sim_time_t sim_end = NRF_NO_EVENT;
+sim_time_t sim_awake;
+unsigned   sim_loss;
+unsigned   sim_min_br;
+unsigned   sim_fault_ms;
+unsigned long sim_isr_cnt;
+
+#define ACLK_HZ       32768UL
+#define ISR_CYCLES    11        // interrupt entry (6) + RETI (5)
+#define TXBUF_EMPTY   0xFFFF    // TXBUF backing value while no write pending
+
+static unsigned char  r8[SIM_REG8_MAX];
+static unsigned short r16[SIM_REG16_MAX];
+static unsigned short sr;
+static unsigned short sr_stack[8];
+static int            isr_depth;
+static unsigned long  seed = 1;
+
+//-----------------------------------------------------------------
+// interrupt vectors of device_lib (only the linked ones exist)
+//-----------------------------------------------------------------
+void Timer_A(void)  __attribute__((weak));   // TIMERA0_VECTOR
+void Timer_A1(void) __attribute__((weak));   // TIMERA1_VECTOR
+void RF24_isr(void) __attribute__((weak));   // PORT1_VECTOR
+void SPI0_rx(void)  __attribute__((weak));   // USART0RX_VECTOR
+void SPI0_tx(void)  __attribute__((weak));   // USART0TX_VECTOR
+void SPI1_rx(void)  __attribute__((weak));   // USART1RX_VECTOR
+void SPI1_tx(void)  __attribute__((weak));   // USART1TX_VECTOR
+
+//-----------------------------------------------------------------
+// board wiring
+//-----------------------------------------------------------------
+struct port_ids { int in, out, dir, sel; };
+
+static const struct port_ids port[7] = {
+  { -1, -1, -1, -1 },
+  { SIM_P1IN, SIM_P1OUT, SIM_P1DIR, SIM_P1SEL },
+  { SIM_P2IN, SIM_P2OUT, SIM_P2DIR, SIM_P2SEL },
+  { SIM_P3IN, SIM_P3OUT, SIM_P3DIR, SIM_P3SEL },
+  { SIM_P4IN, SIM_P4OUT, SIM_P4DIR, SIM_P4SEL },
+  { SIM_P5IN, SIM_P5OUT, SIM_P5DIR, SIM_P5SEL },
+  { SIM_P6IN, SIM_P6OUT, SIM_P6DIR, SIM_P6SEL },
+};
+
+struct pin { int port; unsigned char bit; };
+
+struct wiring {
+  struct pin ce, csn, sck, mosi, miso;
+  unsigned char irq;            // P1 bit
+  int usart;
+};
+
+static const struct wiring wire[NRF_MODULES] = {
+  { {4, BIT4}, {4, BIT5}, {5, BIT3}, {5, BIT1}, {5, BIT2}, BIT4, 1 },   // A: SPI1
+  { {4, BIT6}, {3, BIT0}, {3, BIT3}, {3, BIT1}, {3, BIT2}, BIT7, 0 },   // B: SPI0
+};
+
+// bit-bang SPI slave side state
+struct bitbang {
+  int ce, csn, sck;
+  int rises, bits;
+  unsigned char acc, out;
+  int irq;                      // last IRQ pin level
+};
+
+static struct bitbang bb[NRF_MODULES];
+
+//-----------------------------------------------------------------
+// USART0/1 in SPI master mode
+//-----------------------------------------------------------------
+struct usart {
+  int ctl, rctl, br0, br1, rxbuf;   // register IDs
+  int ifg, ie, me;
+  unsigned char rxifg, txifg, rxie, txie, spie;
+  int enabled, busy, tx_full;
+  unsigned char shift, txb;
+  sim_time_t end;
+};
+
+static struct usart us[2] = {
+  { SIM_U0CTL, SIM_U0RCTL, SIM_U0BR0, SIM_U0BR1, SIM_RXBUF0,
+    SIM_IFG1, SIM_IE1, SIM_ME1, URXIFG0, UTXIFG0, URXIE0, UTXIE0, USPIE0 },
+  { SIM_U1CTL, SIM_U1RCTL, SIM_U1BR0, SIM_U1BR1, SIM_RXBUF1,
+    SIM_IFG2, SIM_IE2, SIM_ME2, URXIFG1, UTXIFG1, URXIE1, UTXIE1, USPIE1 },
+};
+
+//-----------------------------------------------------------------
+// Timer_A
+//-----------------------------------------------------------------
+static sim_time_t     ta_epoch;
+static unsigned long  ta_base;      // TAR at ta_epoch
+static sim_time_t     ta_due;       // next compare/roll-over
+static unsigned short ta_ctl_last, ta_tar_last;
+
+unsigned sim_random(unsigned range)
+{
+  seed = seed * 1103515245UL + 12345UL;
+  return (unsigned)((seed >> 16) & 0x7FFF) % range;
+}
+
+void sim_seed(unsigned long s)
+{
+  seed = s;
+}
+
+//===================================================================
+// pins
+//===================================================================
+static int pin_out(const struct pin *p, int dflt)
+{
+  if (r8[port[p->port].sel] & p->bit) return dflt;  // owned by USART
+  if (!(r8[port[p->port].dir] & p->bit)) return dflt;
+  return (r8[port[p->port].out] & p->bit) != 0;
+}
+
+static void sync_pins(void)
+{
+  int i, v;
+
+  for (i = 0; i < NRF_MODULES; i++) {
+    const struct wiring *w = &wire[i];
+    struct bitbang *b = &bb[i];
+
+    if ((v = pin_out(&w->csn, 1)) != b->csn) {
+      b->csn = v;
+      b->rises = b->bits = 0;
+      b->acc = 0;
+      nrf_set_csn(&nrf[i], v);
+      b->out = nrf_spi_peek(&nrf[i]);
+    }
+
+    if ((v = pin_out(&w->ce, 0)) != b->ce) {
+      b->ce = v;
+      nrf_set_ce(&nrf[i], v);
+    }
+
+    // bit-banged SCK: MOSI sampled on rising, MISO shifted on falling edge
+    v = pin_out(&w->sck, 0);
+    if (v != b->sck) {
+      b->sck = v;
+      if (!b->csn && v) {
+        b->acc = (b->acc << 1) | pin_out(&w->mosi, 0);
+        b->rises++;
+      } else if (!b->csn && b->rises && ++b->bits == 8) {
+        nrf_spi_byte(&nrf[i], b->acc);
+        b->out = nrf_spi_peek(&nrf[i]);
+        b->rises = b->bits = 0;
+        b->acc = 0;
+      }
+    }
+  }
+}
+
+static unsigned char port_in(int n)
+{
+  unsigned char v = 0xFF;
+  int i;
+
+  for (i = 0; i < NRF_MODULES; i++) {
+    const struct wiring *w = &wire[i];
+
+    if (n == 1) {
+      if (!nrf_irq_level(&nrf[i])) v &= ~w->irq;
+    } else if (n == w->miso.port && !(r8[port[n].sel] & w->miso.bit)) {
+      if (bb[i].csn || !((bb[i].out << bb[i].bits) & 0x80)) v &= ~w->miso.bit;
+    }
+  }
+  return v;
+}
+
+// IRQ pins (P1) may have changed: latch P1IFG on the selected edge
+void sim_ports_update(void)
+{
+  int i, lvl;
+
+  for (i = 0; i < NRF_MODULES; i++) {
+    unsigned char bit = wire[i].irq;
+
+    lvl = nrf_irq_level(&nrf[i]);
+    if (lvl == bb[i].irq) continue;
+    bb[i].irq = lvl;
+    if ((r8[SIM_P1IES] & bit) ? !lvl : lvl) r8[SIM_P1IFG] |= bit;
+  }
+}
+
+//===================================================================
+// USART
+//===================================================================
+static void usart_start(struct usart *u, unsigned char v)
+{
+  unsigned br = r8[u->br0] | (r8[u->br1] << 8);
+
+  u->busy = 1;
+  u->shift = v;
+  u->end = sim_now + 8UL * (br < 2 ? 2 : br);
+  r8[u->ifg] |= u->txifg;
+}
+
+static void usart_write(struct usart *u, unsigned char v)
+{
+  if (!u->enabled) return;
+  r8[u->ifg] &= ~u->txifg;
+  if (!u->busy) {
+    usart_start(u, v);
+  } else {
+    u->txb = v;
+    u->tx_full = 1;
+  }
+}
+
+static void usart_event(int n)
+{
+  struct usart *u = &us[n];
+  unsigned char rx = 0xFF;
+  int i;
+
+  for (i = 0; i < NRF_MODULES; i++) {
+    if (wire[i].usart == n && (r8[port[wire[i].sck.port].sel] & wire[i].sck.bit)) {
+      rx = nrf_spi_byte(&nrf[i], u->shift);
+      bb[i].out = nrf_spi_peek(&nrf[i]);
+      if ((r8[u->br0] | (r8[u->br1] << 8)) < sim_min_br) rx ^= 0x01;  // SCK too fast for the wiring
+    }
+  }
+
+  if (r8[u->ifg] & u->rxifg) r8[u->rctl] |= OE;
+  r8[u->rxbuf] = rx;
+  r8[u->ifg] |= u->rxifg;
+
+  u->busy = 0;
+  if (u->tx_full) {
+    u->tx_full = 0;
+    usart_start(u, u->txb);
+  }
+}
+
+static void sync_usart(void)
+{
+  int n, en;
+
+  for (n = 0; n < 2; n++) {
+    struct usart *u = &us[n];
+
+    en = !(r8[u->ctl] & SWRST) && (r8[u->me] & u->spie);
+    if (en != u->enabled) {
+      u->enabled = en;
+      u->busy = u->tx_full = 0;
+      r8[u->ifg] = en ? ((r8[u->ifg] | u->txifg) & ~u->rxifg) : (r8[u->ifg] | u->txifg);
+    }
+    if (r16[SIM_TXBUF0 + n] != TXBUF_EMPTY) {
+      usart_write(u, (unsigned char)r16[SIM_TXBUF0 + n]);
+      r16[SIM_TXBUF0 + n] = TXBUF_EMPTY;
+    }
+  }
+}
+
+//===================================================================
+// Timer_A
+//===================================================================
+static unsigned long ta_src_hz(void)
+{
+  return ((r16[SIM_TACTL] & TASSEL_3) == TASSEL_1) ? ACLK_HZ : SIM_MCLK_HZ;
+}
+
+static unsigned ta_div(void)
+{
+  return 1U << ((r16[SIM_TACTL] >> 6) & 0x03);
+}
+
+static int ta_mode(void)
+{
+  return r16[SIM_TACTL] & MC_3;
+}
+
+// timer counts elapsed from ta_epoch to t
+static unsigned long long ta_counts(sim_time_t t)
+{
+  return (t - ta_epoch) * ta_src_hz() / ((unsigned long long)ta_div() * SIM_MCLK_HZ);
+}
+
+// first MCLK cycle at which 'c' counts have elapsed since ta_epoch
+static sim_time_t ta_time(unsigned long long c)
+{
+  unsigned long long den = ta_src_hz();
+  unsigned long long num = c * ta_div() * SIM_MCLK_HZ;
+
+  return ta_epoch + (num + den - 1) / den;
+}
+
+static unsigned short ta_tar(sim_time_t t)
+{
+  unsigned long long c;
+
+  if (!ta_mode()) return (unsigned short)ta_base;
+  c = ta_base + ta_counts(t);
+  if (ta_mode() == MC_1) return (unsigned short)(c % ((unsigned long)r16[SIM_CCR0] + 1));
+  return (unsigned short)c;
+}
+
+static void ta_rebase(void)
+{
+  ta_base = ta_tar(sim_now);
+  ta_epoch = sim_now;
+}
+
+static void sync_timer(void)
+{
+  unsigned short ctl = r16[SIM_TACTL];
+
+  if (r16[SIM_TAR] != ta_tar_last) {            // TAR written
+    ta_base = r16[SIM_TAR];
+    ta_epoch = sim_now;
+  }
+  if (ctl != ta_ctl_last) {
+    if (ctl & TACLR) {
+      r16[SIM_TACTL] = ctl &= ~TACLR;
+      ta_base = 0;
+      ta_epoch = sim_now;
+    } else {
+      unsigned short now_ctl = ctl;
+
+      r16[SIM_TACTL] = ta_ctl_last;             // count with old settings
+      ta_rebase();
+      r16[SIM_TACTL] = now_ctl;
+    }
+    ta_ctl_last = ctl;
+  }
+  ta_tar_last = r16[SIM_TAR] = ta_tar(sim_now);
+}
+
+static sim_time_t ta_next(void)
+{
+  unsigned long long c, k, best = ~0ULL;
+  unsigned long tar, top;
+  int i;
+
+  if (!ta_mode()) return NRF_NO_EVENT;
+
+  c = ta_counts(sim_now);
+  tar = ta_tar(sim_now);
+  top = (ta_mode() == MC_1) ? r16[SIM_CCR0] : 0xFFFF;
+
+  for (i = 0; i < 3; i++) {
+    unsigned long v = r16[SIM_CCR0 + i];
+
+    if (r16[SIM_CCTL0 + i] & CAP) continue;
+    if (v > top) continue;
+    k = (v > tar) ? v - tar : v + top + 1 - tar;
+    if (k < best) best = k;
+  }
+  k = top + 1 - tar;                            // roll over to 0
+  if (k < best) best = k;
+
+  return ta_time(c + best);
+}
+
+static void ta_event(void)
+{
+  unsigned short tar = ta_tar(sim_now);
+  int i;
+
+  for (i = 0; i < 3; i++) {
+    if (!(r16[SIM_CCTL0 + i] & CAP) && r16[SIM_CCR0 + i] == tar) r16[SIM_CCTL0 + i] |= CCIFG;
+  }
+  if (tar == 0) r16[SIM_TACTL] |= TAIFG;
+  ta_ctl_last = r16[SIM_TACTL];
+}
+
+static unsigned short ta_iv(void)
+{
+  if ((r16[SIM_CCTL1] & (CCIFG | CCIE)) == (CCIFG | CCIE)) { r16[SIM_CCTL1] &= ~CCIFG; return 2; }
+  if ((r16[SIM_CCTL2] & (CCIFG | CCIE)) == (CCIFG | CCIE)) { r16[SIM_CCTL2] &= ~CCIFG; return 4; }
+  if ((r16[SIM_TACTL] & (TAIFG | TAIE)) == (TAIFG | TAIE)) {
+    r16[SIM_TACTL] &= ~TAIFG;
+    ta_ctl_last = r16[SIM_TACTL];
+    return 10;
+  }
+  return 0;
+}
+
+// apply register writes still pending from the last access
+static void sim_sync(void)
+{
+  sync_usart();
+  sync_pins();
+  sync_timer();
+}
+
+//===================================================================
+// interrupts
+//===================================================================
+static void isr_call(void (*isr)(void))
+{
+  sim_isr_cnt++;
+  sr_stack[isr_depth++] = sr;
+  sr &= ~(GIE | LPM4_bits);
+  sim_cycles(ISR_CYCLES);
+  isr();
+  sim_sync();     // last write of the ISR (e.g. TXBUF) takes effect now
+  sr = sr_stack[--isr_depth];
+}
+
+// take the highest priority pending interrupt, F149 vector order
+static int irq_take(void)
+{
+  if (!(sr & GIE) || isr_depth >= (int)(sizeof(sr_stack) / sizeof(sr_stack[0]))) return 0;
+
+  if (SPI0_rx && (r8[SIM_IFG1] & URXIFG0) && (r8[SIM_IE1] & URXIE0)) {
+    isr_call(SPI0_rx);
+    return 1;
+  }
+  if (SPI0_tx && (r8[SIM_IFG1] & UTXIFG0) && (r8[SIM_IE1] & UTXIE0)) {
+    r8[SIM_IFG1] &= ~UTXIFG0;
+    isr_call(SPI0_tx);
+    return 1;
+  }
+  if (Timer_A && (r16[SIM_CCTL0] & (CCIFG | CCIE)) == (CCIFG | CCIE)) {
+    r16[SIM_CCTL0] &= ~CCIFG;
+    isr_call(Timer_A);
+    return 1;
+  }
+  if (Timer_A1 && (((r16[SIM_CCTL1] & (CCIFG | CCIE)) == (CCIFG | CCIE)) ||
+                   ((r16[SIM_CCTL2] & (CCIFG | CCIE)) == (CCIFG | CCIE)) ||
+                   ((r16[SIM_TACTL] & (TAIFG | TAIE)) == (TAIFG | TAIE)))) {
+    isr_call(Timer_A1);
+    return 1;
+  }
+  if (RF24_isr && (r8[SIM_P1IFG] & r8[SIM_P1IE])) {
+    isr_call(RF24_isr);
+    return 1;
+  }
+  if (SPI1_rx && (r8[SIM_IFG2] & URXIFG1) && (r8[SIM_IE2] & URXIE1)) {
+    isr_call(SPI1_rx);
+    return 1;
+  }
+  if (SPI1_tx && (r8[SIM_IFG2] & UTXIFG1) && (r8[SIM_IE2] & UTXIE1)) {
+    r8[SIM_IFG2] &= ~UTXIFG1;
+    isr_call(SPI1_tx);
+    return 1;
+  }
+  return 0;
+}
+
+static void irq_dispatch(void)
+{
+  while (irq_take());
+}
+
+//===================================================================
+// clock
+//===================================================================
+static sim_time_t next_event(void)
+{
+  sim_time_t t = ta_due = ta_next();
+  int i;
+
+  for (i = 0; i < NRF_MODULES; i++) {
+    if (nrf[i].t_event < t) t = nrf[i].t_event;
+  }
+  for (i = 0; i < 2; i++) {
+    if (us[i].busy && us[i].end < t) t = us[i].end;
+  }
+  if (nrf_fault_at < t) t = nrf_fault_at;
+  return t;
+}
+
+static void run_events(void)
+{
+  int i, again;
+
+  do {
+    again = 0;
+    for (i = 0; i < NRF_MODULES; i++) {
+      if (nrf[i].t_event <= sim_now) { nrf_event(&nrf[i]); again = 1; }
+    }
+    for (i = 0; i < 2; i++) {
+      if (us[i].busy && us[i].end <= sim_now) { usart_event(i); again = 1; }
+    }
+    if (nrf_fault_at <= sim_now) { nrf_fault(); again = 1; }
+  } while (again);
+
+  if (ta_due <= sim_now) {
+    ta_due = NRF_NO_EVENT;
+    ta_event();
+  }
+}
+
+static void advance_to(sim_time_t t)
+{
+  sim_time_t next;
+
+  while (sim_now < t) {
+    next = next_event();
+    if (next > t) next = t;
+    if (next > sim_end) next = sim_end;
+
+    if (!(sr & CPUOFF)) sim_awake += next - sim_now;
+    sim_now = next;
+    if (sim_now >= sim_end) sim_finish();
+
+    run_events();
+    irq_dispatch();
+  }
+}
+
+void sim_cycles(unsigned long n)
+{
+  sim_sync();
+  advance_to(sim_now + n);
+}
+
+static void sim_access(void)
+{
+  sim_sync();
+  advance_to(sim_now + SIM_ACCESS_CYCLES);
+  sim_sync();
+}
+
+volatile unsigned char *sim_reg8(int id)
+{
+  sim_access();
+
+  switch (id) {
+  case SIM_P1IN: r8[id] = port_in(1); break;
+  case SIM_P2IN: r8[id] = port_in(2); break;
+  case SIM_P3IN: r8[id] = port_in(3); break;
+  case SIM_P4IN: r8[id] = port_in(4); break;
+  case SIM_P5IN: r8[id] = port_in(5); break;
+  case SIM_P6IN: r8[id] = port_in(6); break;
+  case SIM_RXBUF0: r8[SIM_IFG1] &= ~URXIFG0; break;
+  case SIM_RXBUF1: r8[SIM_IFG2] &= ~URXIFG1; break;
+  case SIM_U0TCTL:
+  case SIM_U1TCTL:
+    {
+      struct usart *u = &us[id == SIM_U1TCTL];
+      r8[id] = (r8[id] & ~TXEPT) | ((u->busy || u->tx_full) ? 0 : TXEPT);
+    }
+    break;
+  default: break;
+  }
+  return &r8[id];
+}
+
+volatile unsigned short *sim_reg16(int id)
+{
+  sim_access();
+
+  if (id == SIM_TAIV) r16[id] = ta_iv();
+  return &r16[id];
+}
+
+//===================================================================
+// status register
+//===================================================================
+void sim_bis_sr(unsigned short bits)
+{
+  sim_access();
+  sr |= bits;
+  irq_dispatch();
+
+  // low power mode: sleep until an ISR clears CPUOFF on exit
+  while (sr & CPUOFF) {
+    sim_time_t t = next_event();
+
+    if (t <= sim_now) t = sim_now + 1;
+    advance_to(t < sim_end ? t : sim_end);
+  }
+}
+
+void sim_bic_sr(unsigned short bits)
+{
+  sim_access();
+  sr &= ~bits;
+}
+
+void sim_bic_sr_on_exit(unsigned short bits)
+{
+  if (isr_depth) sr_stack[isr_depth - 1] &= ~bits;
+}
+
+unsigned short sim_get_sr(void)
+{
+  return sr;
+}
+
+//===================================================================
+// power-on reset
+//===================================================================
+void sim_reset(void)
+{
+  int i;
+
+  memset(r8, 0, sizeof(r8));
+  memset(r16, 0, sizeof(r16));
+  r16[SIM_TXBUF0] = r16[SIM_TXBUF1] = TXBUF_EMPTY;
+  r8[SIM_IFG1] = UTXIFG0;
+  r8[SIM_IFG2] = UTXIFG1;
+  r8[SIM_U0CTL] = r8[SIM_U1CTL] = SWRST;
+  r8[SIM_U0TCTL] = r8[SIM_U1TCTL] = TXEPT;
+
+  sim_now = sim_awake = 0;
+  sr = 0;
+  isr_depth = 0;
+  ta_epoch = 0;
+  ta_base = 0;
+  ta_ctl_last = ta_tar_last = 0;
+  ta_due = NRF_NO_EVENT;
+
+  nrf_init(&nrf[0], "A");
+  nrf_init(&nrf[1], "B");
+  nrf_fault_arm();
+  for (i = 0; i < NRF_MODULES; i++) {
+    memset(&bb[i], 0, sizeof(bb[i]));
+    bb[i].csn = 1;
+    bb[i].irq = 1;
+  }
+  for (i = 0; i < 2; i++) {
+    us[i].enabled = us[i].busy = us[i].tx_full = 0;
+  }
+}
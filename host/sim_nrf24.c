@@ -0,0 +1,606 @@
+// #################################################################
+//
+// nRF24L01+ software model for the host build
+//
+// Notes:
+// - ACK payloads leave the PRX TX FIFO when the ACK is sent
+//   (the real chip holds them until the next new PID arrives)
+// - RX FIFO full: packet dropped and not ACKed, as on the chip
+// - CRC errors only come from the random loss (-l) setting
+//
+// #################################################################
+#include <string.h>
+#include "sim.h"
+
+// register addresses & bits (see rf24_lib.h)
+#define R_CONFIG      0x00
+#define R_EN_AA       0x01
+#define R_EN_RXADDR   0x02
+#define R_SETUP_AW    0x03
+#define R_SETUP_RETR  0x04
+#define R_RF_CH       0x05
+#define R_RF_SETUP    0x06
+#define R_STATUS      0x07
+#define R_OBSERVE_TX  0x08
+#define R_CD          0x09
+#define R_ADDR_P0     0x0A
+#define R_ADDR_P1     0x0B
+#define R_ADDR_P5     0x0F
+#define R_TX_ADDR     0x10
+#define R_RX_PW_P0    0x11
+#define R_FIFO_STATUS 0x17
+#define R_DYNPD       0x1C
+#define R_FEATURE     0x1D
+
+#define C_R_REGISTER  0x00
+#define C_W_REGISTER  0x20
+#define C_ACTIVATE    0x50
+#define C_R_RX_PL_WID 0x60
+#define C_R_RX_PAYLOAD 0x61
+#define C_W_TX_PAYLOAD 0xA0
+#define C_W_ACK_PAYLOAD 0xA8
+#define C_W_TX_NOACK  0xB0
+#define C_FLUSH_TX    0xE1
+#define C_FLUSH_RX    0xE2
+#define C_REUSE_TX_PL 0xE3
+
+#define S_RX_DR       0x40
+#define S_TX_DS       0x20
+#define S_MAX_RT      0x10
+#define S_IRQS        0x70
+
+#define CFG_PWR_UP    0x02
+#define CFG_PRIM_RX   0x01
+#define FT_EN_DPL     0x04
+#define FT_EN_ACK_PAY 0x02
+
+#define PIPE_TX       0xFF    // W_TX_PAYLOAD entry, not an ACK payload
+
+enum {
+  RS_PDOWN,       // PWR_UP = 0
+  RS_PWRUP,       // crystal start-up, Tpd2stby
+  RS_STANDBY,     // Standby-I/II
+  RS_TX_SETTLE,   // PLL settling before TX, 130us
+  RS_TX,          // packet on the air
+  RS_ACK_WAIT,    // PTX waiting for ACK / ARD
+  RS_RX_SETTLE,   // PLL settling before RX, 130us
+  RS_RX,          // listening
+  RS_ACK_TX       // PRX turning around to send an ACK
+};
+
+#define T_SETTLE      SIM_US(130)
+#define T_PD2STBY     SIM_US(1500)
+
+struct nrf24 nrf[NRF_MODULES];
+sim_time_t nrf_fault_at = NRF_NO_EVENT;
+
+//===================================================================
+// helpers
+//===================================================================
+static int aw(struct nrf24 *m)
+{
+  int w = m->reg[R_SETUP_AW] & 0x03;
+  return w ? w + 2 : 5;
+}
+
+static unsigned long rate_kbps(struct nrf24 *m)
+{
+  if (m->reg[R_RF_SETUP] & 0x20) return 250;
+  return (m->reg[R_RF_SETUP] & 0x08) ? 2000 : 1000;
+}
+
+static int crc_len(struct nrf24 *m)
+{
+  if (!(m->reg[R_CONFIG] & 0x08)) return 0;
+  return (m->reg[R_CONFIG] & 0x04) ? 2 : 1;
+}
+
+static int dpl(struct nrf24 *m, int pipe)
+{
+  return (m->reg[R_FEATURE] & FT_EN_DPL) && (m->reg[R_DYNPD] & (1 << pipe));
+}
+
+// Enhanced ShockBurst: preamble, address, 9-bit PCF, payload, CRC
+static sim_time_t airtime(struct nrf24 *m, int len)
+{
+  unsigned long bits = 8UL * (1 + aw(m) + len + crc_len(m)) + 9;
+  return (sim_time_t)bits * SIM_MCLK_HZ / (rate_kbps(m) * 1000UL);
+}
+
+static sim_time_t ard(struct nrf24 *m)
+{
+  return SIM_US(250UL * ((m->reg[R_SETUP_RETR] >> 4) + 1));
+}
+
+static unsigned char status(struct nrf24 *m)
+{
+  unsigned char s = m->reg[R_STATUS] & S_IRQS;
+
+  s |= m->rx_n ? (m->rxf[0].pipe << 1) : 0x0e;
+  if (m->tx_n == NRF_FIFO_DEPTH) s |= 0x01;
+  return s;
+}
+
+static unsigned char fifo_status(struct nrf24 *m)
+{
+  return (m->tx_reuse ? 0x40 : 0) |
+         (m->tx_n == NRF_FIFO_DEPTH ? 0x20 : 0) |
+         (m->tx_n == 0 ? 0x10 : 0) |
+         (m->rx_n == NRF_FIFO_DEPTH ? 0x02 : 0) |
+         (m->rx_n == 0 ? 0x01 : 0);
+}
+
+static void set_irq(struct nrf24 *m, unsigned char bits)
+{
+  m->reg[R_STATUS] |= bits;
+  sim_ports_update();
+}
+
+static void tx_pop(struct nrf24 *m, int idx)
+{
+  if (idx >= m->tx_n) return;
+  memmove(&m->txf[idx], &m->txf[idx + 1], (m->tx_n - idx - 1) * sizeof(struct nrf_pkt));
+  m->tx_n--;
+}
+
+static void rx_push(struct nrf24 *m, const struct nrf_pkt *p, int pipe)
+{
+  m->rxf[m->rx_n] = *p;
+  m->rxf[m->rx_n].pipe = pipe;
+  m->rx_n++;
+  m->st.rx_pkts++;
+  set_irq(m, S_RX_DR);
+}
+
+static int powered(struct nrf24 *m)
+{
+  return (m->reg[R_CONFIG] & CFG_PWR_UP) != 0;
+}
+
+//===================================================================
+// radio state machine
+//===================================================================
+
+// leave Standby when CE, CONFIG and the FIFOs allow it
+static void kick(struct nrf24 *m)
+{
+  if (m->state != RS_STANDBY || !m->ce) return;
+
+  if (m->reg[R_CONFIG] & CFG_PRIM_RX) {
+    m->state = RS_RX_SETTLE;
+    m->t_event = sim_now + T_SETTLE;
+  } else if (m->tx_n && m->txf[0].pipe == PIPE_TX && !(m->reg[R_STATUS] & S_MAX_RT)) {
+    m->state = RS_TX_SETTLE;
+    m->t_event = sim_now + T_SETTLE;
+  }
+}
+
+static void standby(struct nrf24 *m)
+{
+  m->state = RS_STANDBY;
+  m->t_event = NRF_NO_EVENT;
+  kick(m);
+}
+
+// match destination address against the enabled RX pipes of 'r'
+static int rx_pipe(struct nrf24 *r, const unsigned char *a, int w)
+{
+  int p;
+
+  for (p = 0; p < 6; p++) {
+    if (!(r->reg[R_EN_RXADDR] & (1 << p))) continue;
+    if (p < 2) {
+      if (!memcmp(r->addr[p], a, w)) return p;
+    } else if (r->addr[p][0] == a[0] && !memcmp(&r->addr[1][1], &a[1], w - 1)) {
+      return p;
+    }
+  }
+  return -1;
+}
+
+// CRC-16-CCITT over the payload, stands in for the on-air CRC
+static unsigned short pkt_crc(const struct nrf_pkt *pkt)
+{
+  unsigned short crc = 0xffff;
+  int i, b;
+
+  for (i = 0; i < pkt->len; i++) {
+    crc ^= (unsigned short)pkt->data[i] << 8;
+    for (b = 0; b < 8; b++) crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+  }
+  return crc;
+}
+
+// packet from PTX 'm' ends on air now; run every listening PRX
+static void air_deliver(struct nrf24 *m, struct nrf_pkt *pkt)
+{
+  int i, p, w = aw(m);
+  int want_ack;
+  unsigned short crc = pkt_crc(pkt);
+  struct nrf24 *r;
+
+  m->ack_ok = 0;
+  m->ack_pl.len = 0;
+
+  for (i = 0; i < NRF_MODULES; i++) {
+    r = &nrf[i];
+    if (r == m || r->state != RS_RX || r->rx_since > m->tx_start) continue;
+    if (r->reg[R_RF_CH] != m->reg[R_RF_CH] || rate_kbps(r) != rate_kbps(m)) continue;
+    if (aw(r) != w || crc_len(r) != crc_len(m)) continue;
+    if ((p = rx_pipe(r, m->tx_addr, w)) < 0) continue;
+    if (sim_random(1000) < sim_loss) continue;
+    if (dpl(m, 0) != dpl(r, p)) continue;
+    if (!dpl(r, p) && r->reg[R_RX_PW_P0 + p] != pkt->len) continue;
+
+    want_ack = (r->reg[R_EN_AA] & (1 << p)) && !pkt->noack;
+    // a copy only when PID and CRC both match the last packet (datasheet 7.4.3)
+    if (want_ack && r->rx_pid_valid[p] && r->rx_pid[p] == m->tx_pid && r->rx_crc[p] == crc) {
+      r->st.rx_dup++;           // retransmit of a packet already taken
+    } else if (r->rx_n == NRF_FIFO_DEPTH) {
+      r->st.rx_overflow++;      // no room: drop, no ACK
+      continue;
+    } else {
+      rx_push(r, pkt, p);
+      r->rx_pid[p] = m->tx_pid;
+      r->rx_crc[p] = crc;
+      r->rx_pid_valid[p] = 1;
+    }
+
+    if (want_ack) {
+      struct nrf_pkt ack;
+      int k;
+
+      ack.len = 0;
+      if ((r->reg[R_FEATURE] & FT_EN_ACK_PAY) && dpl(r, p)) {
+        for (k = 0; k < r->tx_n; k++) {
+          if (r->txf[k].pipe == p) {
+            ack = r->txf[k];
+            tx_pop(r, k);
+            r->st.ack_pl_tx++;
+            set_irq(r, S_TX_DS);
+            break;
+          }
+        }
+      }
+      r->state = RS_ACK_TX;
+      r->t_event = sim_now + T_SETTLE + airtime(r, ack.len) + T_SETTLE;
+
+      // PTX hears the ACK on pipe 0 only
+      if (!memcmp(m->addr[0], m->tx_addr, w) && sim_random(1000) >= sim_loss &&
+          (!ack.len || ((m->reg[R_FEATURE] & (FT_EN_DPL | FT_EN_ACK_PAY)) ==
+                        (FT_EN_DPL | FT_EN_ACK_PAY) && dpl(m, 0))) &&
+          T_SETTLE + airtime(r, ack.len) <= (ard(m) > SIM_US(250) ? ard(m) : SIM_US(250))) {
+        m->ack_ok = 1;
+        m->ack_pl = ack;
+      }
+    }
+  }
+}
+
+// current TX payload delivered (TX_DS)
+static void tx_done(struct nrf24 *m)
+{
+  if (m->ack_pl.len) {
+    m->st.ack_pl_rx++;
+    if (m->rx_n < NRF_FIFO_DEPTH) rx_push(m, &m->ack_pl, 0);
+  }
+  if (!m->tx_reuse) tx_pop(m, 0);
+  m->st.tx_ds++;
+  set_irq(m, S_TX_DS);
+  standby(m);
+}
+
+static void air_start(struct nrf24 *m)
+{
+  m->state = RS_TX;
+  m->tx_start = sim_now;
+  m->t_event = sim_now + airtime(m, m->txf[0].len);
+  m->st.tx_air++;
+}
+
+void nrf_event(struct nrf24 *m)
+{
+  m->t_event = NRF_NO_EVENT;
+
+  switch (m->state) {
+  case RS_PWRUP:
+    standby(m);
+    break;
+
+  case RS_TX_SETTLE:
+    if (!m->tx_n) { standby(m); break; }
+    m->arc = 0;
+    m->tx_pid = (m->tx_pid + 1) & 0x03;
+    m->reg[R_OBSERVE_TX] &= 0xF0;
+    air_start(m);
+    break;
+
+  case RS_TX:
+    if (!m->tx_n) { standby(m); break; }
+    air_deliver(m, &m->txf[0]);
+    if (!(m->reg[R_EN_AA] & 0x01) || m->txf[0].noack) {
+      m->ack_pl.len = 0;
+      tx_done(m);
+    } else {
+      m->state = RS_ACK_WAIT;
+      m->t_event = sim_now + (m->ack_ok ?
+          T_SETTLE + airtime(m, m->ack_pl.len) : ard(m));
+    }
+    break;
+
+  case RS_ACK_WAIT:
+    if (m->ack_ok) {
+      tx_done(m);
+    } else if (m->arc < (m->reg[R_SETUP_RETR] & 0x0F) && m->tx_n) {
+      m->arc++;
+      m->st.retransmits++;
+      m->reg[R_OBSERVE_TX] = (m->reg[R_OBSERVE_TX] & 0xF0) | m->arc;
+      air_start(m);
+    } else {
+      if ((m->reg[R_OBSERVE_TX] & 0xF0) != 0xF0) m->reg[R_OBSERVE_TX] += 0x10;
+      m->st.max_rt++;
+      set_irq(m, S_MAX_RT);
+      standby(m);
+    }
+    break;
+
+  case RS_RX_SETTLE:
+  case RS_ACK_TX:
+    if (m->ce && powered(m) && (m->reg[R_CONFIG] & CFG_PRIM_RX)) {
+      m->state = RS_RX;
+      m->rx_since = sim_now;
+    } else {
+      standby(m);
+    }
+    break;
+
+  default:
+    break;
+  }
+}
+
+//===================================================================
+// pins
+//===================================================================
+void nrf_set_ce(struct nrf24 *m, int level)
+{
+  if (m->ce == level) return;
+  m->ce = level;
+
+  if (level) {
+    kick(m);
+  } else if (m->state == RS_RX || m->state == RS_RX_SETTLE) {
+    standby(m);
+  }
+}
+
+int nrf_irq_level(struct nrf24 *m)
+{
+  // CONFIG MASK_RX_DR/TX_DS/MAX_RT line up with the STATUS bits
+  return !(m->reg[R_STATUS] & S_IRQS & ~m->reg[R_CONFIG]);
+}
+
+//===================================================================
+// register file
+//===================================================================
+static void write_reg(struct nrf24 *m, unsigned char r, int i, unsigned char b)
+{
+  unsigned char old;
+
+  if (r == R_ADDR_P0 || r == R_ADDR_P1) {
+    if (i < 5) m->addr[r - R_ADDR_P0][i] = b;
+    return;
+  }
+  if (r == R_TX_ADDR) {
+    if (i < 5) m->tx_addr[i] = b;
+    return;
+  }
+  if (i) return;
+  if (r > R_ADDR_P1 && r <= R_ADDR_P5) {
+    m->addr[r - R_ADDR_P0][0] = b;
+    return;
+  }
+
+  switch (r) {
+  case R_CONFIG:
+    old = m->reg[R_CONFIG];
+    m->reg[R_CONFIG] = b & 0x7F;
+    if ((old & CFG_PWR_UP) && !(b & CFG_PWR_UP)) {
+      m->state = RS_PDOWN;
+      m->t_event = NRF_NO_EVENT;
+    } else if (!(old & CFG_PWR_UP) && (b & CFG_PWR_UP)) {
+      m->state = RS_PWRUP;
+      m->t_event = sim_now + T_PD2STBY;
+    } else if (((old ^ b) & CFG_PRIM_RX) &&
+               (m->state == RS_RX || m->state == RS_RX_SETTLE || m->state == RS_STANDBY)) {
+      standby(m);
+    }
+    sim_ports_update();
+    break;
+  case R_STATUS:
+    m->reg[R_STATUS] &= ~(b & S_IRQS);
+    sim_ports_update();
+    kick(m);
+    break;
+  case R_RF_CH:
+    m->reg[R_RF_CH] = b & 0x7F;
+    m->reg[R_OBSERVE_TX] &= 0x0F;   // PLOS_CNT reset
+    break;
+  case R_OBSERVE_TX:
+  case R_CD:
+  case R_FIFO_STATUS:
+    break;                          // read only
+  default:
+    if (r >= R_RX_PW_P0 && r < R_RX_PW_P0 + 6) b &= 0x3F;
+    m->reg[r] = b;
+    break;
+  }
+}
+
+static unsigned char read_reg(struct nrf24 *m, unsigned char r, int i)
+{
+  if (r == R_ADDR_P0 || r == R_ADDR_P1) return (i < 5) ? m->addr[r - R_ADDR_P0][i] : 0;
+  if (r == R_TX_ADDR) return (i < 5) ? m->tx_addr[i] : 0;
+  if (r > R_ADDR_P1 && r <= R_ADDR_P5) return m->addr[r - R_ADDR_P0][0];
+  if (r == R_STATUS) return status(m);
+  if (r == R_FIFO_STATUS) return fifo_status(m);
+  return m->reg[r];
+}
+
+//===================================================================
+// SPI slave
+//===================================================================
+static unsigned char cmd_miso(struct nrf24 *m, int i)
+{
+  unsigned char c = m->spi_cmd;
+
+  if (c < C_W_REGISTER) return read_reg(m, c & 0x1F, i);
+  if (c == C_R_RX_PL_WID) return (i == 0 && m->rx_n) ? m->rxf[0].len : 0;
+  if (c == C_R_RX_PAYLOAD) return (m->rx_n && i < 32) ? m->rxf[0].data[i] : 0;
+  return 0;
+}
+
+static int is_payload_cmd(unsigned char c)
+{
+  return c == C_W_TX_PAYLOAD || c == C_W_TX_NOACK || (c >= C_W_ACK_PAYLOAD && c <= C_W_ACK_PAYLOAD + 5);
+}
+
+static void cmd_start(struct nrf24 *m)
+{
+  unsigned char c = m->spi_cmd;
+
+  if (c == C_FLUSH_TX) {
+    m->tx_n = 0;
+    m->tx_reuse = 0;
+  } else if (c == C_FLUSH_RX) {
+    m->rx_n = 0;
+  } else if (c == C_REUSE_TX_PL) {
+    m->tx_reuse = 1;
+  } else if (is_payload_cmd(c)) {
+    m->spi_pl.len = 0;
+    m->spi_pl.noack = (c == C_W_TX_NOACK);
+    m->spi_pl.pipe = (c >= C_W_ACK_PAYLOAD && c <= C_W_ACK_PAYLOAD + 5) ? (c & 0x07) : PIPE_TX;
+  }
+}
+
+void nrf_set_csn(struct nrf24 *m, int level)
+{
+  if (m->csn == level) return;
+  m->csn = level;
+
+  if (!level) {                     // start of transaction
+    m->spi_idx = 0;
+    m->miso_next = status(m);
+    return;
+  }
+
+  // end of transaction
+  if (m->spi_idx) m->st.spi_frames++;
+  if (m->spi_idx > 1 && is_payload_cmd(m->spi_cmd) && m->tx_n < NRF_FIFO_DEPTH) {
+    m->txf[m->tx_n++] = m->spi_pl;
+    if (m->spi_pl.pipe == PIPE_TX) m->tx_reuse = 0;
+    kick(m);
+  } else if (m->spi_idx > 1 && m->spi_cmd == C_R_RX_PAYLOAD && m->rx_n) {
+    memmove(&m->rxf[0], &m->rxf[1], (m->rx_n - 1) * sizeof(struct nrf_pkt));
+    m->rx_n--;
+  }
+  m->spi_idx = 0;
+}
+
+unsigned char nrf_spi_peek(struct nrf24 *m)
+{
+  return m->csn ? 0xFF : m->miso_next;
+}
+
+unsigned char nrf_spi_byte(struct nrf24 *m, unsigned char mosi)
+{
+  unsigned char out;
+
+  if (m->csn) return 0xFF;          // MISO tri-stated
+
+  out = m->miso_next;
+  m->st.spi_bytes++;
+
+  if (m->spi_idx == 0) {
+    m->spi_cmd = mosi;
+    cmd_start(m);
+  } else if ((m->spi_cmd & 0xE0) == C_W_REGISTER) {
+    write_reg(m, m->spi_cmd & 0x1F, m->spi_idx - 1, mosi);
+  } else if (is_payload_cmd(m->spi_cmd) && m->spi_idx <= 32) {
+    m->spi_pl.data[m->spi_idx - 1] = mosi;
+    m->spi_pl.len = m->spi_idx;
+  }
+  m->spi_idx++;
+  m->miso_next = cmd_miso(m, m->spi_idx - 1);
+  return out;
+}
+
+//===================================================================
+// power-on reset values
+//===================================================================
+void nrf_init(struct nrf24 *m, const char *name)
+{
+  int p;
+
+  memset(m, 0, sizeof(*m));
+  m->name = name;
+  m->csn = 1;
+  m->state = RS_PDOWN;
+  m->t_event = NRF_NO_EVENT;
+
+  m->reg[R_CONFIG] = 0x08;
+  m->reg[R_EN_AA] = 0x3F;
+  m->reg[R_EN_RXADDR] = 0x03;
+  m->reg[R_SETUP_AW] = 0x03;
+  m->reg[R_SETUP_RETR] = 0x03;
+  m->reg[R_RF_CH] = 0x02;
+  m->reg[R_RF_SETUP] = 0x0E;
+  m->reg[R_STATUS] = 0x0E;
+  for (p = 0; p < 5; p++) {
+    m->addr[0][p] = 0xE7;
+    m->addr[1][p] = 0xC2;
+    m->tx_addr[p] = 0xE7;
+  }
+  for (p = 2; p < 6; p++) m->addr[p][0] = 0xC1 + p;
+}
+
+//===================================================================
+// radio upsets (-f): one module at random, 0.5~1.5 x sim_fault_ms
+// apart
+//===================================================================
+void nrf_fault_arm(void)
+{
+  nrf_fault_at = sim_fault_ms ?
+      sim_now + SIM_US(500UL * sim_fault_ms + (unsigned long)sim_random(1000) * sim_fault_ms) :
+      NRF_NO_EVENT;
+}
+
+void nrf_fault(void)
+{
+  struct nrf24 *m = &nrf[sim_random(NRF_MODULES)];
+  struct nrf24 keep;
+
+  switch (sim_random(3)) {
+  case 0:                           // Standby, left only on a CE edge
+    if (m->state <= RS_PWRUP) break;
+    m->state = RS_STANDBY;
+    m->t_event = NRF_NO_EVENT;
+    break;
+  case 1:                           // PLL never locks, PWR_UP cycle needed
+    if (m->state <= RS_PWRUP) break;
+    m->state = (m->reg[R_CONFIG] & CFG_PRIM_RX) ? RS_RX_SETTLE : RS_TX_SETTLE;
+    m->t_event = NRF_NO_EVENT;
+    break;
+  default:                          // brown-out: power-on reset, pins kept
+    keep = *m;
+    nrf_init(m, keep.name);
+    m->ce = keep.ce;
+    m->csn = keep.csn;
+    m->spi_idx = keep.spi_idx;
+    m->st = keep.st;
+    sim_ports_update();
+    break;
+  }
+  m->st.faults++;
+  nrf_fault_arm();
+}
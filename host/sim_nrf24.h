@@ -0,0 +1,95 @@
+// #################################################################
+//
+// nRF24L01+ software model for the host build
+//
+// - register file, 3-deep TX/RX FIFOs, STATUS/FIFO_STATUS/OBSERVE_TX
+// - DYNPD/FEATURE, ACK payloads, PID duplicate filter
+// - Enhanced ShockBurst airtime: 130us settling, packet airtime,
+//   auto-ACK turnaround and ARD/ARC auto-retransmit
+//
+// - radio upsets (-f): Standby w/o CE edge, PLL stuck settling,
+//   brown-out (power-on register values, FIFOs lost)
+//
+// SPI is driven a byte (USART) or a bit (GPIO) at a time by
+// sim_msp430.c; times are in MCLK cycles of the board model.
+//
+// #################################################################
+#ifndef _SIM_NRF24_H_
+#define _SIM_NRF24_H_
+
+#define NRF_MODULES     2     // RF24L01_A, RF24L01_B
+#define NRF_FIFO_DEPTH  3
+#define NRF_NO_EVENT    (~0ULL)
+
+typedef unsigned long long sim_time_t;
+
+struct nrf_pkt {
+  unsigned char len;
+  unsigned char pipe;       // RX: pipe received on, TX: ACK payload pipe
+  unsigned char noack;      // W_TX_PAYLOAD_NOACK
+  unsigned char data[32];
+};
+
+struct nrf_stats {
+  unsigned long spi_bytes;    // bytes clocked while CSN low
+  unsigned long spi_frames;   // CSN-framed transactions
+  unsigned long tx_air;       // packets put on the air (incl. retransmits)
+  unsigned long tx_ds;        // TX_DS events (PTX: delivered / ACKed)
+  unsigned long max_rt;       // MAX_RT events
+  unsigned long retransmits;
+  unsigned long rx_pkts;      // payloads accepted into RX FIFO
+  unsigned long rx_dup;       // duplicates filtered by PID
+  unsigned long rx_overflow;  // dropped, RX FIFO full
+  unsigned long ack_pl_tx;    // ACK payloads sent (PRX)
+  unsigned long ack_pl_rx;    // ACK payloads received (PTX)
+  unsigned long faults;       // upsets injected (-f)
+};
+
+struct nrf24 {
+  const char *name;
+
+  unsigned char reg[0x20];          // single byte registers
+  unsigned char addr[6][5];         // RX_ADDR_P0..P5 (P2~P5: LSB only)
+  unsigned char tx_addr[5];
+
+  struct nrf_pkt txf[NRF_FIFO_DEPTH];
+  int tx_n, tx_reuse;
+  struct nrf_pkt rxf[NRF_FIFO_DEPTH];
+  int rx_n;
+
+  // pins
+  int ce, csn;
+
+  // SPI transaction in progress
+  int spi_idx;
+  unsigned char spi_cmd, miso_next;
+  struct nrf_pkt spi_pl;
+
+  // radio
+  int state;
+  sim_time_t t_event;               // next state machine event
+  sim_time_t rx_since;              // listening since (PRX)
+  sim_time_t tx_start;              // current packet airtime start
+  int ack_ok;                       // PTX: ACK will arrive for current packet
+  struct nrf_pkt ack_pl;            // PTX: payload carried by that ACK
+  int arc;                          // retransmit count of current packet
+  unsigned char tx_pid, rx_pid[6], rx_pid_valid[6];
+  unsigned short rx_crc[6];         // PRX: CRC of the last packet per pipe (dup check)
+
+  struct nrf_stats st;
+};
+
+extern struct nrf24 nrf[NRF_MODULES];
+extern sim_time_t nrf_fault_at;     // next upset injected, NRF_NO_EVENT: none
+
+void          nrf_init(struct nrf24 *m, const char *name);
+void          nrf_set_ce(struct nrf24 *m, int level);
+void          nrf_set_csn(struct nrf24 *m, int level);
+unsigned char nrf_spi_peek(struct nrf24 *m);                   // MISO of next byte
+unsigned char nrf_spi_byte(struct nrf24 *m, unsigned char mosi);
+int           nrf_irq_level(struct nrf24 *m);                   // pin 8, active low
+void          nrf_event(struct nrf24 *m);                       // t_event reached
+void          nrf_fault_arm(void);                              // next upset in ~sim_fault_ms
+void          nrf_fault(void);                                  // nrf_fault_at reached
+
+#endif // _SIM_NRF24_H_
@@ -30,18 +30,110 @@ void init_led(void) {
 #endif
 }
 
+//=============================================
+// LED output queue: steps played by led_tm,
+// 'tail' step on LEDs (on or off phase)
+//=============================================
+typedef struct {
+    unsigned char pat;      // LEDs on, bit 0: LED1
+    unsigned char on;       // msec shown, 0: held until the next step
+    unsigned char off;      // msec all off after, 0: none
+    unsigned char cnt;      // times left, LED_FOREVER: until led_clear()
+} led_step_t;
+
+static led_step_t led_q[LED_Q_SIZE];
+static unsigned char led_head;      // next step to queue
+static unsigned char led_tail;      // step playing
+static unsigned char led_off;       // 1: tail step in its off phase
+static tm_timer_t led_tm;
+
+// 8-bit value to LEDs in reverse order, one port write (LEDs active low)
+static void led_out(unsigned char pat)
+{
+    P2OUT = ~pat;
+}
+
+// play the queue from the tail step on, until a step needs time
+// (led_tm armed) or the queue runs dry (last pattern left on)
+static void led_play(tm_timer_t *t)
+{
+    led_step_t *s;
+
+    while (led_head != led_tail) {
+        s = &led_q[led_tail & LED_Q_MASK];
+        if (!led_off) {
+            led_out(s->pat);
+            if (s->on) {
+                led_off = 1;
+                tm_start(&led_tm, s->on / TM_TIME_MS, 0, led_play);
+                return;
+            }
+            led_tail++;             // held: next step replaces it
+            continue;
+        }
+        
+        led_off = 0;
+        if (s->cnt != LED_FOREVER && --s->cnt == 0) led_tail++;
+        if (s->off) {
+            led_out(0);
+            tm_start(&led_tm, s->off / TM_TIME_MS, 0, led_play);
+            return;
+        }
+    }
+}
+
+//******************************************************************************************
+// queue 'pat' shown 'on' msec, all off 'off' msec, 'cnt' times
+//******************************************************************************************
+int led_flash(unsigned char pat, unsigned char on, unsigned char off, unsigned char cnt)
+{
+    led_step_t *s;
+
+    if (cnt == 0) return 1;
+    if ((unsigned char)(led_head - led_tail) >= LED_Q_SIZE) return 0;
+
+    s = &led_q[led_head & LED_Q_MASK];
+    s->pat = pat;
+    s->on = on;
+    s->off = off;
+    s->cnt = cnt;
+    led_head++;
+    
+    if (led_tm.state != TM_ARMED) led_play(&led_tm);    // idle: start now
+    return 1;
+}
+
+//******************************************************************************************
+// drop the queued steps, all LEDs off
+//******************************************************************************************
+void led_clear(void)
+{
+    tm_stop(&led_tm);
+    led_tail = led_head;
+    led_off = 0;
+    LED_ALL_0;
+}
+
+//******************************************************************************************
+// steps queued or playing, an onerr() blink left aside
+//******************************************************************************************
+int led_busy(void)
+{
+    if (led_head == led_tail) return (led_tm.state == TM_ARMED);    // last off phase
+    return (led_q[led_tail & LED_Q_MASK].cnt != LED_FOREVER);
+}
+
+//******************************************************************************************
+// nothing queued or playing, an onerr() blink included
+//******************************************************************************************
+int led_idle(void)
+{
+    return (led_head == led_tail) && (led_tm.state != TM_ARMED);
+}
+
 // display 8-bit value to LEDs in reverse order 
 void show(unsigned char chkpt) {
-#if 1
-    (chkpt & 0x01) ? LED1_1 : LED1_0;
-    (chkpt & 0x02) ? LED2_1 : LED2_0;
-    (chkpt & 0x04) ? LED3_1 : LED3_0;
-    (chkpt & 0x08) ? LED4_1 : LED4_0;
-    (chkpt & 0x10) ? LED5_1 : LED5_0;
-    (chkpt & 0x20) ? LED6_1 : LED6_0;
-    (chkpt & 0x40) ? LED7_1 : LED7_0;
-    (chkpt & 0x80) ? LED8_1 : LED8_0;
-#endif
+    led_flash(chkpt, 0, 0, 1);
 }
 
 
@@ -62,27 +154,16 @@ void show(unsigned char chkpt) {
 #endif
     
 //******************************************************************************************
-// flash checkpoint (0~255) on 8 leds on error then halt program execution
+// flash checkpoint (0~255) on 8 leds on error for ever, in the background
 //******************************************************************************************
 void onerr(unsigned char chkpt) {
-#if 1
-  while (1) {
-    show(chkpt);
-    delay_ms(200);
-    LED_ALL_0;
-    delay_ms(200);
-  }
-#endif 
+    led_clear();
+    led_flash(chkpt, LED_ERR_MS, LED_ERR_MS, LED_FOREVER);
 }
 
 //******************************************************************************************
-// flash checkpoint (0~255) on 8 leds on error then halt program execution
+// flash checkpoint (0~255) on 8 leds once
 //******************************************************************************************
 void display(unsigned char chkpt) {
-#if 1
-    show(chkpt);
-    delay_ms(100);
-    LED_ALL_0;
-    delay_ms(10);
-#endif
+    led_flash(chkpt, LED_ON_MS, LED_OFF_MS, 1);
 }
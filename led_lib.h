@@ -2,6 +2,10 @@
 //
 // MSP430F149 LEDx8 Routines on P2.x ports 
 //
+// show()/display()/onerr() queue LED steps, played in the background
+// by a deadline timer (tm_run() in the main loop), none of them waits.
+// Main loop context only (no ISR).
+//
 // #################################################################
 #ifndef _LED_LIB_H_
 #define _LED_LIB_H_
@@ -33,6 +37,25 @@
 #define LED_ALL_0   (P2OUT |= 0xff)     // ALL LEDs OFF
 #define LED_ALL_1   (P2OUT &= 0x00)     // ALL LEDs ON
 
+//==============================================================================
+//
+// LED output queue
+//
+//==============================================================================
+#ifndef LED_Q_SIZE
+ #define LED_Q_SIZE  16             // # of queued steps, power of 2 (<= 128)
+#endif
+#define LED_Q_MASK  (LED_Q_SIZE - 1)
+
+#if (LED_Q_SIZE & LED_Q_MASK) || (LED_Q_SIZE > 128)
+ #error "LED_Q_SIZE must be a power of 2 up to 128"
+#endif
+
+#define LED_ON_MS   100             // display() flash on/off in msec
+#define LED_OFF_MS  10
+#define LED_ERR_MS  200             // onerr() blink on/off in msec
+#define LED_FOREVER 0xff            // step count: repeated until led_clear()
+
 //********************************************************************
 //
 // Unit Test Register Setting Validation Macro
@@ -55,20 +78,42 @@
 void init_led(void);
 
 //******************************************************************************************
-// display 8-bit value to LEDs in reverse order 
+// display 8-bit value to LEDs in reverse order (queued, held until the next step)
 //******************************************************************************************
 void show(unsigned char chkpt);
 
 //******************************************************************************************
-// flash checkpoint (0~255) on 8 leds on error then halt program execution
+// flash checkpoint (0~255) on 8 leds on error for ever, in the background;
+// later steps stay queued until led_clear()
 //******************************************************************************************
 void onerr(unsigned char chkpt);
 
 //******************************************************************************************
-// flash checkpoint (0~255) on 8 leds on error then halt program execution
+// flash checkpoint (0~255) on 8 leds once (queued, LED_ON_MS + LED_OFF_MS)
 //******************************************************************************************
 void display(unsigned char chkpt);
 
+//******************************************************************************************
+// queue 'pat' shown 'on' msec then all off 'off' msec, 'cnt' times (LED_FOREVER)
+// 'on' 0: held until the next step; returns 0 if the queue is full (step dropped)
+//******************************************************************************************
+int led_flash(unsigned char pat, unsigned char on, unsigned char off, unsigned char cnt);
+
+//******************************************************************************************
+// drop the queued steps (an onerr() blink too), all LEDs off
+//******************************************************************************************
+void led_clear(void);
+
+//******************************************************************************************
+// steps still queued or playing (1/0), an onerr() blink does not count
+//******************************************************************************************
+int led_busy(void);
+
+//******************************************************************************************
+// nothing queued or playing, an onerr() blink neither (1/0): LEDs free to write
+//******************************************************************************************
+int led_idle(void);
+
 #endif  // _LED_LIB_H_
 
 
@@ -31,12 +31,15 @@
 #include "../device_lib/rf24_if_cfg.h"  // interfaced with SPI or GPIO ports
 
 // MSP430 family includes
-#include <string.h>
 #include <msp430f149.h>
 #include "../device_lib/timer_lib.h"
+#include "../device_lib/sched_lib.h"
 #include "../device_lib/led_lib.h"
 #include "../device_lib/pb_lib.h"
 #include "../device_lib/rf24_lib.h"
+#include "../device_lib/rf24_stats.h"
+#include "../device_lib/rf24_ackpl.h"
+#include "../device_lib/rf24_recov.h"
 
 #ifdef  _RF24_SPI_  
  // via SPI port
@@ -50,8 +53,42 @@
   #define DBG_STATUS
 #endif
 
+#ifdef RF24_XPORT   // IRQ pin or STATUS polling on the port picked
+ #ifdef RF24_IRQ
+  #define XP_IRQ    RF24_XP_IRQ
+ #else
+  #define XP_IRQ    RF24_XP_POLL
+ #endif
+#endif
+
+//=====================================================
+// Scheduler tasks (sched_lib), 0: highest priority
+//=====================================================
+#define TASK_PRX    0       // RF B: RX FIFO -> Rx2_Ring -> application
+#define TASK_PTX    1       // RF A: TX FIFO loading, TX outcome
+#define TASK_UI     2       // push button debug display
+
+// no IRQ edge readies the task of module n: run every round
+#if defined(RF24_XPORT) && defined(RF24_IRQ)
+ #define RF_POLLED(n)   (rf24_xp[n].irq == RF24_XP_POLL)
+#elif defined(RF24_IRQ)
+ #define RF_POLLED(n)   0
+#else
+ #define RF_POLLED(n)   1
+#endif
+
 #define LOOP  10    // display debug value loop
 
+// radio loop LED activity: only while the LED queue is idle, an onerr()
+// blink or PB_SHOW()/display() steps are not overwritten; the process
+// step (halt_led_toggle) not ORed into the packet rate shown (DSP_RATE)
+#define LOOP_LED_ALL_0      { if (led_idle()) LED_ALL_0; }
+#ifdef DSP_RATE
+ #define LOOP_LED(on)
+#else
+ #define LOOP_LED(on)       { if (halt_led_toggle && led_idle()) on; }
+#endif
+
 //=====================================================================
 //
 //      << nRF24L01p modules configuration >>
@@ -87,7 +124,9 @@
 //==========================NRF24L01============================================
 #define TX_ADR_WIDTH 	5 	        // 5 bytes TX address width
 #define RX_ADR_WIDTH 	5 	        // 5 bytes RX address width
-#define DATA_SIZE       2           // 32 or 1~31 (DYNPL)
+#ifndef DATA_SIZE
+ #define DATA_SIZE      2           // 32 or 1~31 (DYNPL)
+#endif
 #define TX_PL_WIDTH 	DATA_SIZE 	// TX payload size
 #define RX_PL_WIDTH 	DATA_SIZE 	// RX payload size
 #define ACK_PL_WIDTH    5           // ACK payload size 
@@ -125,20 +164,104 @@ unsigned char ADDR_P4_BUF[RX_ADR_WIDTH] = { '4', 'N','O','D','E' }; //Pipe#4 add
 unsigned char ADDR_P5_BUF[RX_ADR_WIDTH] = { '5', 'N','O','D','E' }; //Pipe#5 address
 unsigned char *PIPE_ADDR_LIST[6] = {ADDR_P0_BUF, ADDR_P1_BUF, ADDR_P2_BUF, ADDR_P3_BUF, ADDR_P4_BUF, ADDR_P5_BUF}; //RF_A PTX TX/RX_P1~5 address
 
+//============================================================
+// Radio profiles, loaded by nRF24L01_CfgLoad() after the
+// soft-reset: registers already holding the value (shadow
+// image) not written. CONFIG (PWR_UP) last
+//============================================================
+const rf24_cfg_t RF_A_cfg[] = {     // RF_A: PTX
+#ifdef AUTO_ACK
+    RF24_CFG_REG(EN_AA, EN_AA_PIPES),       // enable Auto.Ack:Pipe0~5
+    RF24_CFG_REG(FEATURE, RF_FEATURE),      // enable EN_DPL, disable EN_ACK_PL
+    RF24_CFG_REG(DYNPD, EN_AA_PIPES),       // enable DYNPL on Pipe0~5
+    RF24_CFG_REG(SETUP_RETR, RETRY),        // timeout:5, retry:5
+    RF24_CFG_REG(EN_RXADDR, 0x01),          // Enable RX Pipe0 for the ACK
+#else
+    RF24_CFG_REG(EN_AA, 0x0),               // disable Auto.Ack for all Pipe0~5
+    RF24_CFG_REG(FEATURE, 0x0),             // disable EN_ACK_PL & EN_DPL
+    RF24_CFG_REG(DYNPD, 0x0),               // disable DYNPL on Pipe0~5
+    RF24_CFG_REG(SETUP_RETR, 0x0),          // no TX timeoue & retry
+    RF24_CFG_REG(EN_RXADDR, 0x0),           // Disable all RX Pipe0~5
+#endif
+    RF24_CFG_REG(RF_CH, RF_CHANNEL),        // Select channel
+    RF24_CFG_REG(RF_SETUP, RF_SETUP_V),     // TX_PWR:0dBm, Datarate:1-2Mbps, LNA:HCURR
+    RF24_CFG_REG(CONFIG, CONFIG_PTX),       // IRQ sources, PWR_UP bit, enable CRC(2 bytes) & Prim:TX
+};
+
+const rf24_cfg_t RF_B_cfg[] = {     // RF_B: PRX
+    // all six RX pipe Addresses
+    RF24_CFG_ADDR(ADDR_P0, ADDR_P0_BUF, RX_ADR_WIDTH),
+    RF24_CFG_ADDR(ADDR_P1, ADDR_P1_BUF, RX_ADR_WIDTH),
+    RF24_CFG_ADDR(ADDR_P2, ADDR_P2_BUF, 1),     // LSB only
+    RF24_CFG_ADDR(ADDR_P3, ADDR_P3_BUF, 1),     // LSB only
+    RF24_CFG_ADDR(ADDR_P4, ADDR_P4_BUF, 1),     // LSB only
+    RF24_CFG_ADDR(ADDR_P5, ADDR_P5_BUF, 1),     // LSB only
+#if (RF_DYNPD == 0x00)
+    // static rx payload width if DYN_PL not enabled
+    RF24_CFG_REG(RX_PW_P0, RX_PL_WIDTH),
+    RF24_CFG_REG(RX_PW_P1, RX_PL_WIDTH),
+    RF24_CFG_REG(RX_PW_P2, RX_PL_WIDTH),
+    RF24_CFG_REG(RX_PW_P3, RX_PL_WIDTH),
+    RF24_CFG_REG(RX_PW_P4, RX_PL_WIDTH),
+    RF24_CFG_REG(RX_PW_P5, RX_PL_WIDTH),
+#endif
+#ifdef AUTO_ACK
+    RF24_CFG_REG(EN_AA, EN_AA_PIPES),       // enable Auto.Ack for all Pipe0~5
+    RF24_CFG_REG(FEATURE, RF_FEATURE),      // enable EN_ACK_PL & EN_DPL
+    RF24_CFG_REG(DYNPD, EN_AA_PIPES),       // enable DYNPL on all Pipe0~5
+    RF24_CFG_REG(SETUP_RETR, RETRY),        // timeout and retry
+#else
+    RF24_CFG_REG(EN_AA, 0x0),               // disable Auto.Ack for all Pipe0~5
+    RF24_CFG_REG(FEATURE, 0x0),             // disable EN_ACK_PL & EN_DPL
+    RF24_CFG_REG(DYNPD, 0x0),               // disable DYNPL on Pipe0~5
+    RF24_CFG_REG(SETUP_RETR, 0x0),          // no TX timeoue & retry
+#endif
+    RF24_CFG_REG(EN_RXADDR, EN_RX_PIPES),   // Enable RX Pipe (one or all 6 pipes)
+    RF24_CFG_REG(RF_CH, RF_CHANNEL),        // Select channel
+    RF24_CFG_REG(RF_SETUP, RF_SETUP_V),     // TX_PWR:0dBm, Datarate:1-2Mbps, LNA:HCURR
+    RF24_CFG_REG(CONFIG, CONFIG_PRX),       // IRQ sources, PWR_UP bit, enable CRC(2 bytes) & Prim:RX
+};
+
 // Globals Declaration
 unsigned char ACK_Buf[32]; 
-unsigned char tf, Rx1_Buf[32], Tx1_Buf[32], Rx2_Buf[32], Tx2_Buf[32];
+unsigned char tf, Tx2_Buf[32];
+rf24_rx_pkt_t Rx1_Pkt[3];   // RX FIFO drained per batch (3 deep)
+rx_ring_t Rx2_Ring;          // PRX packets queued for RX_B_consume()
 unsigned char data[] = "Tested Message";
+
+// PTX payload: sequence # header + message (0s up to TX_PL_WIDTH),
+// clocked out straight from here by nRF24L01_TxPacketSG()
+#define TX_MSG_LEN  ((TX_PL_WIDTH - 1) < sizeof(data) ? (TX_PL_WIDTH - 1) : sizeof(data))
+unsigned char tx_hdr;
+rf24_seg_t tx_seg[3] = { { &tx_hdr, 1 }, { data, TX_MSG_LEN }, { 0, TX_PL_WIDTH - 1 - TX_MSG_LEN } };
 int  mode_a;   // RF A process mode
 int  mode_b;   // RF B process mode
 int  sts1, sts2, sts3, sts4;
 unsigned char rt_cnt,to_a_cnt, to_b_cnt;   
 unsigned char tx_pkt_rate, rx_pkt_rate;
 int  rx_cnt, tx_cnt, has_rx;
+tm_timer_t tm_tx, tm_rx, tm_rate;   // TX/RX keep-alive deadlines, 1 sec rate window
+#if TX_PERIOD
+tm_timer_t tm_txp;          // PTX pacing, every TX_PERIOD msec
+unsigned char tx_credit;    // payloads allowed by tm_txp, not yet sent
+#endif
 int  halt_led_toggle;
 int  tx_pipe_no;   // current TX pipe in used
 unsigned char ack_cnt;
 
+#ifdef ACK_POOL
+#ifdef TX_6_PIPES
+ #define ACK_PIPES  0x3f        // PTX walks all 6 pipes
+#else
+ #define ACK_PIPES  PIPE_SLOT   // PTX on RX_PIPE only
+#endif
+ack_pool_t Ack_Pool;            // RF_B ACK payloads per pipe
+#endif
+
+#ifdef TX_STREAM
+void RF_A_tx_done(int nrf24, int result);   // streaming TX payload outcome
+#endif
+
 //****************************************************************************************
 //
 // NRF24L01p A init as PTX mode
@@ -155,13 +278,16 @@ void init_NRF24L01_A(void)
      */
   
     // for NRF24_A
+    SPI_SYNC(RF24L01_A);  // no SPI transaction in flight
     RF24L01_A_CE_0;  // disable RF TX/RX until start TX or into RX mode
     RF24L01_A_CSN_1; // disable SPI operations
 
 #ifndef  _RF24_SPI_
     RF24L01_A_SCK_0; // Spi clock line init high
-#endif 
-    inerDelay(100);
+    inerDelay(100);     // SCK settled (GPIO)
+#endif
+    nRF24L01_CfgSync(RF24L01_A);   // profile image kept, power-on or unknown
+    STATS_FLUSH(RF24L01_A);        // TX FIFO flushed, PLOS_CNT resynced
     
     /*  nRF24L01p Soft-reset sequence
      *  1)use power down mode (PWR_UP = 0) 
@@ -172,28 +298,11 @@ void init_NRF24L01_A(void)
     SPI_RW_Reg(RF24L01_A, WRITE_REG + STATUS, 0x70);  // clear RX_DR, TX_DS, MAX_RT bits
     SPI_Write_Reg(RF24L01_A, FLUSH_TX);               // flush TX buffer    
     SPI_Write_Reg(RF24L01_A, FLUSH_RX);               // flush RX buffer    
-  
-#ifdef AUTO_ACK
-    SPI_RW_Reg(RF24L01_A, WRITE_REG + EN_AA, EN_AA_PIPES);  // enable Auto.Ack:Pipe0~5
-    SPI_RW_Reg(RF24L01_A, WRITE_REG + FEATURE, RF_FEATURE); // enable EN_DPL, disable EN_ACK_PL
-    SPI_RW_Reg(RF24L01_A, WRITE_REG + DYNPD, EN_AA_PIPES);  // enable DYNPL on Pipe0~5
-    SPI_RW_Reg(RF24L01_A, WRITE_REG + SETUP_RETR, RETRY);   // timeout:5, retry:5
-    SPI_RW_Reg(RF24L01_A, WRITE_REG + EN_RXADDR, 0x01);     // Enable RX Pipe0 for the ACK
-#else
-    SPI_RW_Reg(RF24L01_A, WRITE_REG + EN_AA, 0x0);          // disable Auto.Ack for all Pipe0~5
-    SPI_RW_Reg(RF24L01_A, WRITE_REG + FEATURE, 0x0);        // disable EN_ACK_PL & EN_DPL
-    SPI_RW_Reg(RF24L01_A, WRITE_REG + DYNPD, 0x0);          // disable DYNPL on Pipe0~5
-    SPI_RW_Reg(RF24L01_A, WRITE_REG + SETUP_RETR, 0x0);     // no TX timeoue & retry
-    SPI_RW_Reg(RF24L01_A, WRITE_REG + EN_RXADDR, 0x0);      // Disable all RX Pipe0~5
-#endif
-    SPI_RW_Reg(RF24L01_A, WRITE_REG + RF_CH, RF_CHANNEL);   // Select channel
-    SPI_RW_Reg(RF24L01_A, WRITE_REG + RF_SETUP, RF_SETUP_V);    // TX_PWR:0dBm, Datarate:1-2Mbps, LNA:HCURR
-
-#ifdef RF24_IRQ     
-    SPI_RW_Reg(RF24L01_A, WRITE_REG + CONFIG, 0x3e); // Enable RX_DR IRQ pin, sel PWR_UP bit, enable CRC(2 bytes) & Prim:TX. RX_DR enabled..
-#else
-    SPI_RW_Reg(RF24L01_A, WRITE_REG + CONFIG, 0x7e); // Disable IRQ pin, set PWR_UP bit, enable CRC(2 bytes) & Prim:TX. RX_DR enabled..
+#ifdef TX_STREAM
+    nRF24L01_TxStreamInit(RF24L01_A, RF_A_tx_done);  // TX FIFO empty
 #endif
+  
+    if (nRF24L01_CfgLoad(RF24L01_A, RF_A_cfg, RF24_CFG_N(RF_A_cfg)) < 0) onerr(3);
 
 #ifdef AUTO_ACK 
     // setup validation if RF module accessible
@@ -201,6 +310,28 @@ void init_NRF24L01_A(void)
 #endif   
 }
 
+#ifdef ACK_POOL
+//****************************************************************************************
+//
+// NRF24L01p B ACK payloads: every pipe served queue topped up
+// (ack_cnt in ACK_IDX), then TX FIFO slots loaded from the pool
+//
+//***************************************************************************************/
+void ACK_B_refill(void)
+{
+    int p;
+
+    for (p = 0; p < 6; p++) {
+        if (!(ACK_PIPES & (1 << p))) continue;
+        while (ack_pool_room(&Ack_Pool, p)) {
+            ACK_Buf[ACK_IDX] = ++ack_cnt;
+            ack_pool_put(&Ack_Pool, p, ACK_Buf, ACK_PL_WIDTH);
+        }
+    }
+    ack_pool_fill(RF24L01_B, &Ack_Pool);
+}
+#endif
+
 //****************************************************************************************
 //
 // NRF24L01p B init as PRX mode
@@ -211,31 +342,16 @@ void init_NRF24L01_B(void)
 //     unsigned char byte;
 
     // for NRF24_B
+    SPI_SYNC(RF24L01_B);  // no SPI transaction in flight
     RF24L01_B_CE_0;  // disable RF TX/RX until start TX or into RX mode
     RF24L01_B_CSN_1; // Spi disable
 
 #ifndef _RF24_SPI_   
     RF24L01_B_SCK_0; // Spi clock line init high
+    inerDelay(100);     // SCK settled (GPIO)
 #endif
-    inerDelay(100);
+    nRF24L01_CfgSync(RF24L01_B);   // profile image kept, power-on or unknown
     
-    // Setup all six RX pipe Addresses & payload width
-    SPI_Write_Buf(RF24L01_B, WRITE_REG + ADDR_P0, ADDR_P0_BUF, RX_ADR_WIDTH);
-    SPI_Write_Buf(RF24L01_B, WRITE_REG + ADDR_P1, ADDR_P1_BUF, RX_ADR_WIDTH);
-    SPI_Write_Buf(RF24L01_B, WRITE_REG + ADDR_P2, ADDR_P2_BUF, 1); // LSB only
-    SPI_Write_Buf(RF24L01_B, WRITE_REG + ADDR_P3, ADDR_P3_BUF, 1); // LSB only
-    SPI_Write_Buf(RF24L01_B, WRITE_REG + ADDR_P4, ADDR_P4_BUF, 1); // LSB only
-    SPI_Write_Buf(RF24L01_B, WRITE_REG + ADDR_P5, ADDR_P5_BUF, 1); // LSB only
-    
-    // Set static rx payload width if DYN_PL not enabled
-#if (RF_DYNPD == 0x00)
-    SPI_RW_Reg(RF24L01_B, WRITE_REG + RX_PW_P0, RX_PL_WIDTH);
-    SPI_RW_Reg(RF24L01_B, WRITE_REG + RX_PW_P1, RX_PL_WIDTH);
-    SPI_RW_Reg(RF24L01_B, WRITE_REG + RX_PW_P2, RX_PL_WIDTH);
-    SPI_RW_Reg(RF24L01_B, WRITE_REG + RX_PW_P3, RX_PL_WIDTH);
-    SPI_RW_Reg(RF24L01_B, WRITE_REG + RX_PW_P4, RX_PL_WIDTH);
-    SPI_RW_Reg(RF24L01_B, WRITE_REG + RX_PW_P5, RX_PL_WIDTH);
-#endif
     /*  nRF24L01p Soft-reset sequence
      *  1)use power down mode (PWR_UP = 0) 
      *  2)clear data ready flag and data sent flag in status register 
@@ -246,29 +362,13 @@ void init_NRF24L01_B(void)
     SPI_Write_Reg(RF24L01_B, FLUSH_TX);               // flush TX buffer    
     SPI_Write_Reg(RF24L01_B, FLUSH_RX);               // flush RX buffer    
 
-#ifdef AUTO_ACK
-    SPI_RW_Reg(RF24L01_B, WRITE_REG + EN_AA, EN_AA_PIPES);  // enable Auto.Ack for all Pipe0~5
-    SPI_RW_Reg(RF24L01_B, WRITE_REG + FEATURE, RF_FEATURE); // enable EN_ACK_PL & EN_DPL
-    SPI_RW_Reg(RF24L01_B, WRITE_REG + DYNPD, EN_AA_PIPES);  // enable DYNPL on all Pipe0~5
-    SPI_RW_Reg(RF24L01_B, WRITE_REG + SETUP_RETR, RETRY);   // timeout and retry
-#else
-    SPI_RW_Reg(RF24L01_B, WRITE_REG + EN_AA, 0x0);        // disable Auto.Ack for all Pipe0~5
-    SPI_RW_Reg(RF24L01_B, WRITE_REG + FEATURE, 0x0);      // disable EN_ACK_PL & EN_DPL
-    SPI_RW_Reg(RF24L01_B, WRITE_REG + DYNPD, 0x0);        // disable DYNPL on Pipe0~5
-    SPI_RW_Reg(RF24L01_B, WRITE_REG + SETUP_RETR, 0x0);   // no TX timeoue & retry
-#endif
-    SPI_RW_Reg(RF24L01_B, WRITE_REG + EN_RXADDR, EN_RX_PIPES);  // Enable RX Pipe (one or all 6 pipes)
-    SPI_RW_Reg(RF24L01_B, WRITE_REG + RF_CH, RF_CHANNEL); // Select channel
-    SPI_RW_Reg(RF24L01_B, WRITE_REG + RF_SETUP, RF_SETUP_V);    // TX_PWR:0dBm, Datarate:1-2Mbps, LNA:HCURR
-
-#ifdef RF24_IRQ     
-    SPI_RW_Reg(RF24L01_B, WRITE_REG + CONFIG, 0x3f); // Enable RX_DR IRQ pin, sel PWR_UP bit, enable CRC(2 bytes) & Prim:RX. RX_DR enabled..
-#else
-    SPI_RW_Reg(RF24L01_B, WRITE_REG + CONFIG, 0x7f); // Disable IRQ pin, set PWR_UP bit, enable CRC(2 bytes) & Prim:RX. RX_DR enabled..
-#endif
+    if (nRF24L01_CfgLoad(RF24L01_B, RF_B_cfg, RF24_CFG_N(RF_B_cfg)) < 0) onerr(4);
 
             // Writes ACK data to the pipe payload will Rx    
-#ifdef TX_6_PIPES
+#ifdef ACK_POOL
+    ack_pool_init(&Ack_Pool, ACK_PIPES);  // TX FIFO flushed above
+    ACK_B_refill();
+#elif defined(TX_6_PIPES)
     ACK_Buf[ACK_IDX] = ++ack_cnt;
     SPI_Write_Buf(RF24L01_B, WR_ACK_PLOAD + 0, ACK_Buf, ACK_PL_WIDTH); 
     ACK_Buf[ACK_IDX] = ++ack_cnt;
@@ -287,85 +387,346 @@ void init_NRF24L01_B(void)
 #endif
 }
 
+#ifdef RF24_RECOV
+// NRF24L01p B full reconfigure of the last recovery tier
+void RF_B_reinit(void)
+{
+    init_NRF24L01_B();
+    SetRX_Mode(RF24L01_B);  // RF B receive mode only (RF A TX mode only)
+}
+#endif
+
+/*===============================================
+ *
+ *  PTX pacing (TX_PERIOD), 
+ *  TX_ready(): payload allowed now ?
+ *  TX_taken(): payload queued
+ *
+ *===============================================
+ */
+#if TX_PERIOD
+void TX_pace(tm_timer_t *t)
+{
+    if (tx_credit < 3) tx_credit++;   // no more than TX FIFO
+    sched_ready(SCHED_BIT(TASK_PTX));
+}
+#endif
+
+int TX_ready(void)
+{
+#if TX_PERIOD
+    return (tx_credit != 0);
+#else
+    return 1;
+#endif
+}
+
+void TX_taken(void)
+{
+#if TX_PERIOD
+    if (tx_credit) tx_credit--;
+#endif
+}
+
+/*===============================================
+ *
+ *  TX/RX keep-alive deadline passed: its task 
+ *  checks it (tm_expired())
+ *
+ *===============================================
+ */
+void KA_wake(tm_timer_t *t)
+{
+    sched_ready((t == &tm_tx) ? SCHED_BIT(TASK_PTX) : SCHED_BIT(TASK_PRX));
+}
+
+/*===============================================
+ *
+ *  TX/RX packet rate (maximum per second), 
+ *  periodic tm_rate callback every TM_SEC
+ *
+ *===============================================
+ */
+void RATE_tick(tm_timer_t *t)
+{
+#ifdef ENABLE_PTX
+    if (tx_cnt > tx_pkt_rate) { 
+        tx_pkt_rate = (tx_cnt < 256) ? tx_cnt : 255;
+  #ifdef DSP_RATE
+
+        // flash rate update indicator (LED queue, in the background)
+        led_flash(0x55, LED_ON_MS, LED_OFF_MS, LOOP);
+       
+        // any data rx at PRX ?
+    #ifdef ENABLE_PRX
+        if (has_rx) {
+          show(tx_pkt_rate);
+        } else {
+          onerr(0xff);
+        }
+    #else
+        show(tx_pkt_rate);
+    #endif
+  #endif
+    }
+    tx_cnt = 0;
+#else
+    if (rx_cnt > rx_pkt_rate) { 
+        rx_pkt_rate = (rx_cnt < 256) ? rx_cnt : 255;
+  #ifdef DSP_RATE
+
+        // flash rate update indicator (LED queue, in the background)
+        led_flash(0x55, LED_ON_MS, LED_OFF_MS, LOOP);
+       
+        show(rx_pkt_rate);
+  #endif
+    }
+    rx_cnt = 0;
+#endif
+}
+
+#ifdef AUTO_ACK
+/*===============================================
+ *
+ *  nRF24L01p A optional ACK payloads
+ *  (RF24_EVT: rx_ready handler)
+ *
+ *===============================================
+ */
+void RF_A_ack_pl(int nrf24, int pipe)
+{
+    int i;
+    rf24_rx_pkt_t *pkt;
+
+    for (i = nRF24L01_RxBatch(nrf24, Rx1_Pkt, 3), pkt = Rx1_Pkt; i > 0; i--, pkt++) 
+    {
+        // RX packet size validation
+        if (pkt->len != ACK_PL_WIDTH) onerr(10);    
+        
+        // RX ACK alway from pipe #0
+        if (pkt->pipe != 0) onerr(11);    
+        STATS_ACK_PL(nrf24, STATS_LAST_TX, pkt->len);
+        
+#ifdef DSP_ACK
+        display(pkt->data[ACK_IDX]);
+#endif
+    }
+}
+#endif
+
+#ifdef TX_STREAM
+/*===============================================
+ *
+ *  nRF24L01p A streaming TX payload outcome
+ *
+ *===============================================
+ */
+void RF_A_tx_done(int nrf24, int result)
+{
+    STATS_TX_DONE(nrf24, result);
+    if (result == TX_OK) {
+        RECOV_OK(nrf24);
+        tm_start(&tm_tx, TX_TMOUT, 0, KA_wake);   // TX KA
+        tx_cnt++;
+    } else if (result == TX_MAX_RT) {
+        if (++rt_cnt == 0) rt_cnt--;
+    }
+}
+#endif
+
 /*===============================================
  *
  *  nRF24L01p A handling
  *
  *===============================================
  */
+#ifdef TX_STREAM
+// Streaming: keep TX FIFO filled, *mode_p = # payloads in TX FIFO
 void RF_A_process(int *mode_p)
 {
     static unsigned char rec_cnt = 0;     
-#ifdef  AUTO_ACK    
-    int pipe;
-    unsigned char size;
+    int queued;
+
+  #ifndef DSP_RATE
+    LOOP_LED_ALL_0;
+  #endif
+    LOOP_LED(LED1_1);
+
+    // retire sent payloads, then top up TX FIFO by one payload per pass
+    // (RF B shares the loop, the FIFO depth covers the SPI round trips)
+#ifdef RF24_EVT
+    nRF24L01_Dispatch(RF24L01_A);   // retired on TX_DS/MAX_RT, ACK payloads
+#endif
+    queued = nRF24L01_TxStreamPoll(RF24L01_A);
+    if (queued < 3 && TX_ready()) do {
+        tx_hdr = rec_cnt + 1; //just any value will do
+        
+#ifdef TX_6_PIPES
+        // new TX pipe only when TX FIFO drained (TX_ADDR shared by FIFO)
+        if (queued == 0) {
+            tx_pipe_no = (tx_pipe_no + 1) % 6;
+        }
+        if (!nRF24L01_TxStreamSG(RF24L01_A, PIPE_ADDR_LIST[tx_pipe_no], TX_ADR_WIDTH, tx_seg, 3)) break;
+        STATS_TX(RF24L01_A, tx_pipe_no, TX_PL_WIDTH);
+#else
+        if (!nRF24L01_TxStreamSG(RF24L01_A, PIPE_ADDR_LIST[RX_PIPE], TX_ADR_WIDTH, tx_seg, 3)) break;
+        STATS_TX(RF24L01_A, RX_PIPE, TX_PL_WIDTH);
 #endif
+        rec_cnt++;
+        TX_taken();
+        if (queued++ == 0) tm_start(&tm_tx, RECOV_TMOUT(RF24L01_A, TX_TMOUT), 0, KA_wake);   // TX KA
+        
+    #ifdef DSP_TX
+        display(tx_hdr);
+    #endif
+    } while (0);
+    *mode_p = queued;
+    
+#ifdef DBG_STATUS
+    sts1 = rf24_status(RF24L01_A);
+#endif
+
+#if defined(AUTO_ACK) && !defined(RF24_EVT)
+    // check for optional ACK payloads
+  #ifndef RF24_IRQ
+    if (rf24_status(RF24L01_A) & ST_RX_DR)
+  #endif
+    RF_A_ack_pl(RF24L01_A, 0);
+#endif
+
+    // no payload retired for a while ?
+    if (queued && tm_expired(&tm_tx)) {
+        if (++to_a_cnt == 0) to_a_cnt--;  
+#ifdef RF24_RECOV
+        if (rf24_recover(RF24L01_A) < RCV_INIT) {
+            nRF24L01_TxStreamInit(RF24L01_A, RF_A_tx_done);  // TX FIFO flushed
+        }
+        sts2 = rf24_recov[RF24L01_A].fifo;  // FIFO_STATUS diagnosed
+#else
+        sts2 = SPI_Read(RF24L01_A, READ_REG + FIFO_STATUS);
+        init_NRF24L01_A();  // stream restarted empty
+#endif
+        *mode_p = 0;
+    }
+    
+  #ifndef DSP_RATE
+    LOOP_LED_ALL_0;
+  #endif
+}
+#else
+// TX_DS: go read ACK payload (RF24_EVT: tx_done handler)
+void RF_A_sent(int nrf24)
+{
+    STATS_TX_DONE(nrf24, TX_OK);
+    RECOV_OK(nrf24);
+    mode_a = 2;
+}
+
+// MAX_RT: drop this packet and send next one (RF24_EVT: tx_failed handler)
+void RF_A_failed(int nrf24)
+{
+    if (++rt_cnt == 0) rt_cnt--;
+    STATS_TX_DONE(nrf24, TX_MAX_RT);
+    sts2 = SPI_Read(nrf24, READ_REG + FIFO_STATUS);
+    // flush tx data first
+    SPI_Write_Reg(nrf24, FLUSH_TX);               // flush TX buffer 
+    mode_a = 0;
+}
+
+void RF_A_process(int *mode_p)
+{
+    static unsigned char rec_cnt = 0;     
     
     switch (*mode_p)
     {
     case 0:
       #ifndef DSP_RATE
-        LED_ALL_0;
+        LOOP_LED_ALL_0;
       #endif
-        if (halt_led_toggle) LED1_1;
+        LOOP_LED(LED1_1);
         // ready to send next packet
         // send next record
+        if (!TX_ready()) break;     // paced, not yet
              
-        sts1 = SPI_Read(RF24L01_A, READ_REG + STATUS);
+#ifdef RF24_EVT
+        sts1 = 0;   // TX_DS/MAX_RT/ACK payload already taken by the handlers
+#else
+        sts1 = SPI_Status(RF24L01_A);
+#endif
         if (sts1 & ST_RX_DR) {
           *mode_p = 2;  // need read the ACK data
         } else {  
-          strcpy((char *)&Tx1_Buf[1], (char *)&data[0]);
-          Tx1_Buf[0] = ++rec_cnt; //just any value will do
-          SPI_RW_Reg(RF24L01_A, WRITE_REG + STATUS, (ST_TX_DS | ST_MAX_RT));  //clear TX bits
+          tx_hdr = ++rec_cnt; //just any value will do
+          if (sts1 & (ST_TX_DS | ST_MAX_RT)) {
+            SPI_RW_Reg(RF24L01_A, WRITE_REG + STATUS, (ST_TX_DS | ST_MAX_RT));  //clear TX bits
+          }
           
           //
           // TX on single pipe or six pipes in turn ?
           // 
 #ifdef TX_6_PIPES
-          nRF24L01_TxPacket(RF24L01_A, PIPE_ADDR_LIST[tx_pipe_no++], TX_ADR_WIDTH, Tx1_Buf, TX_PL_WIDTH); // send the buffer packet
-          tx_pipe_no %= 6;  // set next one
+          nRF24L01_TxPacketSG(RF24L01_A, PIPE_ADDR_LIST[tx_pipe_no], TX_ADR_WIDTH, tx_seg, 3); // send header + message
+          STATS_TX(RF24L01_A, tx_pipe_no, TX_PL_WIDTH);
+          tx_pipe_no = (tx_pipe_no + 1) % 6;  // set next one
 #else
-          nRF24L01_TxPacket(RF24L01_A, PIPE_ADDR_LIST[RX_PIPE], TX_ADR_WIDTH, Tx1_Buf, TX_PL_WIDTH); // send the buffer packet
+          nRF24L01_TxPacketSG(RF24L01_A, PIPE_ADDR_LIST[RX_PIPE], TX_ADR_WIDTH, tx_seg, 3); // send header + message
+          STATS_TX(RF24L01_A, RX_PIPE, TX_PL_WIDTH);
 #endif
-          reset_tm(TM_TX);   // TX KA
+          tm_start(&tm_tx, RECOV_TMOUT(RF24L01_A, TX_TMOUT), 0, KA_wake);   // TX KA
+          TX_taken();
       
         #ifdef DSP_TX
-          display(Tx1_Buf[0]);
+          display(tx_hdr);
         #endif
           *mode_p = 1;  // next step
         }
 
       #ifndef DSP_RATE
-        LED_ALL_0;
+        LOOP_LED_ALL_0;
       #endif
         break;
         
     case 1:
       #ifndef DSP_RATE
-        LED_ALL_0;
+        LOOP_LED_ALL_0;
       #endif
-        if (halt_led_toggle) LED2_1;
+        LOOP_LED(LED2_1);
         
-#if 1
-        sts1 = SPI_Read(RF24L01_A, READ_REG + STATUS);
-        sts2 = SPI_Read(RF24L01_A, READ_REG + FIFO_STATUS);
+#if defined(RF24_EVT)
+        // TX_DS/MAX_RT edge -> RF_A_sent()/RF_A_failed(), ACK payload -> RF_A_ack_pl()
+        nRF24L01_Dispatch(RF24L01_A);
+        if (*mode_p == 1 && tm_expired(&tm_tx)) {
+          if (++to_a_cnt == 0) to_a_cnt--;  
+#ifdef RF24_RECOV
+          rf24_recover(RF24L01_A);  // TX FIFO flushed at least
+          sts2 = rf24_recov[RF24L01_A].fifo;
+#else
+          sts2 = SPI_Read(RF24L01_A, READ_REG + FIFO_STATUS);
+          init_NRF24L01_A();
+#endif
+          *mode_p = 0; // restart TX
+        }
+#elif 1
+        sts1 = SPI_Status(RF24L01_A);
         
         // is TX/ACK ready
         if (sts1 & ST_TX_DS) {
           // clear this status bit
           SPI_RW_Reg(RF24L01_A, WRITE_REG + STATUS, ST_TX_DS); // clear RX_DR ready flags
-          *mode_p = 2; // go read ACK payload 
+          RF_A_sent(RF24L01_A);
         } else if (sts1 & ST_MAX_RT) {
-          if (++rt_cnt == 0) rt_cnt--;
-          // flush tx data first
-          SPI_Write_Reg(RF24L01_A, FLUSH_TX);               // flush TX buffer 
+          RF_A_failed(RF24L01_A);
           // clear this status bit
           SPI_RW_Reg(RF24L01_A, WRITE_REG + STATUS, ST_MAX_RT); // clear MAX_RT flags
-          *mode_p = 0; // drop this packet and send next packet
-        } else if (get_tm(TM_TX) >= TX_TMOUT) {
+        } else if (tm_expired(&tm_tx)) {
           if (++to_a_cnt == 0) to_a_cnt--;  
+#ifdef RF24_RECOV
+          rf24_recover(RF24L01_A);  // TX FIFO flushed at least
+          sts2 = rf24_recov[RF24L01_A].fifo;
+#else
+          sts2 = SPI_Read(RF24L01_A, READ_REG + FIFO_STATUS);
           init_NRF24L01_A();
+#endif
           *mode_p = 0; // restart TX
         }     
 #else
@@ -373,333 +734,305 @@ void RF_A_process(int *mode_p)
 #endif 
         
       #ifndef DSP_RATE
-        LED_ALL_0;
+        LOOP_LED_ALL_0;
       #endif
         break;
 
     case 2:
       #ifndef DSP_RATE
-        LED_ALL_0;
+        LOOP_LED_ALL_0;
       #endif
-        if (halt_led_toggle) LED3_1;
-        // TX done 
-#ifdef AUTO_ACK
+        LOOP_LED(LED3_1);
+        // TX done (RF24_EVT: ACK payload taken with the TX_DS edge)
+#if defined(AUTO_ACK) && !defined(RF24_EVT)
         
 #ifdef DBG_STATUS
-        sts1 = SPI_Read(RF24L01_A, READ_REG + STATUS);
         sts2 = SPI_Read(RF24L01_A, READ_REG + FIFO_STATUS);
+        sts1 = rf24_status(RF24L01_A);  // clocked back with FIFO_STATUS
 #endif
         
-        // check for optional ACK payload
-        if ((pipe = nRF24L01_RxPacket(RF24L01_A, Rx1_Buf, &size)) != -1) 
-        {
-          // RX packet size validation
-          if (size != ACK_PL_WIDTH) onerr(10);    
-          
-          // RX ACK alway from pipe #0
-          if (pipe != 0) onerr(11);    
-          
-          // RX ACK
-#ifdef DSP_ACK
-          display(Rx1_Buf[ACK_IDX]);
-#endif
-        }
+        // check for optional ACK payloads
+        RF_A_ack_pl(RF24L01_A, 0);
 #endif 
         
-        // caculate the TX packet rate 
+        // count for the TX packet rate 
         tx_cnt++;
-        
-        if (get_tm(TM_RATE) >= TM_SEC) {
-            if (tx_cnt > tx_pkt_rate) { 
-                tx_pkt_rate = (tx_cnt < 256) ? tx_cnt : 255;
-#ifdef DSP_RATE
-
-                // flash rate update indicator
-                for (int i=0; i<LOOP; i++) {
-                  display(0x55);
-                }
-               
-                // any data rx at PRX ?
-            #ifdef ENABLE_PRX
-                if (has_rx) {
-                  show(tx_pkt_rate);
-                } else {
-                  onerr(0xff);
-                }
-            #else
-                show(tx_pkt_rate);
-            #endif
-#endif
-            }
-            tx_cnt = 0;
-            reset_tm(TM_RATE);
-        }
             
         *mode_p = 0;  // TX next packet
         // FALLTHRU
     default:
       #ifndef DSP_RATE
-        LED_ALL_0;
+        LOOP_LED_ALL_0;
       #endif
         break;
     }
 }
 
+#endif // TX_STREAM
+
 /*===============================================
  *
  *  nRF24L01p B handling
  *
  *===============================================
  */
+// RX packets from the sender ? (whole RX FIFO into the ring)
+// (RF24_EVT: rx_ready handler)
+void RF_B_rx_ready(int nrf24, int pipe)
+{
+    if (nRF24L01_RxRing(nrf24, &Rx2_Ring)) {
+#ifdef DBG_STATUS
+        sts3 = rf24_status(nrf24);  // clocked back with RD_RX_PL_WID
+#endif  
+        RECOV_OK(nrf24);
+        tm_start(&tm_rx, RX_TMOUT, 0, KA_wake);   // RX KA
+    }
+}
+
 void RF_B_process(int *mode_p)
 {
-    unsigned char size;
-    int pipe, cnt;
-    
     switch (*mode_p)
     {
     case 0:
       #ifndef DSP_RATE
-        LED_ALL_0;
+        LOOP_LED_ALL_0;
       #endif
-        if (halt_led_toggle) LED5_1;
+        LOOP_LED(LED5_1);
         *mode_p = 1;
-        reset_tm(TM_RX);   // RX KA
+        tm_start(&tm_rx, RECOV_TMOUT(RF24L01_B, RX_TMOUT), 0, KA_wake);   // RX KA
         
       #ifndef DSP_RATE
-        LED_ALL_0;
+        LOOP_LED_ALL_0;
       #endif
         break;
 
     case 1:
       #ifndef DSP_RATE
-        LED_ALL_0;
+        LOOP_LED_ALL_0;
       #endif
-        if (halt_led_toggle) LED5_1;
+        LOOP_LED(LED5_1);
 
-#ifdef DBG_STATUS
-        sts3 = SPI_Read(RF24L01_B, READ_REG + STATUS);
-#endif  
-        sts4 = SPI_Read(RF24L01_B, READ_REG + FIFO_STATUS);
-        
-        // RX packet from the sender ?
-        if ((pipe = nRF24L01_RxPacket(RF24L01_B, Rx2_Buf, &size)) != -1) 
-        {
-            // RX packet size validation
-            if (size != DATA_SIZE) onerr(12);;  
-            
-            // packet Rx
-            has_rx = 1; // PRX  received data
-#ifdef DSP_RX
-            display(Rx2_Buf[0]);
-#endif  
-
-#ifdef ACK_PL
-            sts3 = SPI_Read(RF24L01_B, READ_REG + STATUS);
-            if ((sts3 & ST_TX_FULL) == 0) {
-              // setup first auto-ACK if TX BIFO not full (max 3 ACK_PL)
-              ACK_Buf[ACK_IDX] = ++ack_cnt;
-              // Writes ACK data to the pipe payload will Rx
-              SPI_Write_Buf(RF24L01_B, WR_ACK_PLOAD + pipe, ACK_Buf, ACK_PL_WIDTH); 
-            }
+#ifdef RF24_EVT
+        nRF24L01_Dispatch(RF24L01_B);   // RX_DR edge -> RF_B_rx_ready()
+#else
+        RF_B_rx_ready(RF24L01_B, 0);
 #endif
-
-#ifndef ENABLE_PTX
-            // caculate the RX packet rate 
-            rx_cnt++;
-            cnt = rx_cnt;
-            
-            if (get_tm(TM_RATE) >= TM_SEC) {
-              if (cnt > rx_pkt_rate) { 
-              rx_pkt_rate = (cnt < 256) ? cnt : 255;
-  #ifdef DSP_RATE
-
-                // flash rate update indicator
-                for (int i=0; i<LOOP; i++) {
-                  display(0x55);
-                }
-               
-                show(rx_pkt_rate);
-  #endif
-              }
-              rx_cnt = 0;
-              reset_tm(TM_RATE);
-            }
+        if (tm_expired(&tm_rx)) {
+            sts4 = SPI_Read(RF24L01_B, READ_REG + FIFO_STATUS);
+#ifdef ACK_POOL
+            ack_pool_fifo(&Ack_Pool, sts4);
 #endif
-            *mode_p = 0;
 #ifdef AUTO_ACK            
-        } else if (sts4 & FF_TX_EMPTY) {
-            // Rreset ACK gone, TX FIFO become empty, reset mode to get ready to RX
-            *mode_p = 0;
+            if (sts4 & FF_TX_EMPTY) {
+                // Rreset ACK gone, TX FIFO become empty, reset mode to get ready to RX
+                *mode_p = 0;
+            } else
 #endif            
-        } else if (get_tm(TM_RX) >= RX_TMOUT) {
-            // treat as KA heartbeat 
-            if (++to_b_cnt == 0) to_b_cnt--;
-            // is on TX_FIFO full ? (comm. dead)
-            if (sts4 & FF_RX_EMPTY) {
-                init_NRF24L01_B();  // soft-reset nRF24
-                SetRX_Mode(RF24L01_B);  // RF B receive mode only (RF A TX mode only)
+            {
+                // treat as KA heartbeat 
+                if (++to_b_cnt == 0) to_b_cnt--;
+#ifdef RF24_RECOV
+                // flags, RX FIFO or CONFIG tell what is stuck
+                rf24_recover(RF24L01_B);
+#else
+                // is on TX_FIFO full ? (comm. dead)
+                if (sts4 & FF_RX_EMPTY) {
+                    init_NRF24L01_B();  // soft-reset nRF24
+                    SetRX_Mode(RF24L01_B);  // RF B receive mode only (RF A TX mode only)
+                }
+#endif
+                *mode_p = 0; // restart TX
             }
-            *mode_p = 0; // restart TX
         }
         // FALLTHRU
         
     default:
       #ifndef DSP_RATE
-        LED_ALL_0;
+        LOOP_LED_ALL_0;
       #endif
         break;
     }
 }
 
+/*===============================================
+ *
+ *  nRF24L01p B received packets consumer
+ *
+ *===============================================
+ */
+void RX_B_consume(void)
+{
+    rf24_rx_pkt_t *pkt;
+    
+    while ((pkt = rx_ring_peek(&Rx2_Ring)) != 0) 
+    {
+        // RX packet size validation
+        if (pkt->len != DATA_SIZE) onerr(12);;  
+        
+        // packet Rx
+        has_rx = 1; // PRX  received data
+        STATS_RX(RF24L01_B, pkt->pipe, pkt->len);
+#ifdef DSP_RX
+        display(pkt->data[0]);
+#endif  
+
+#ifdef ACK_POOL
+        ack_pool_rx(&Ack_Pool, pkt->pipe);  // its ACK took the pipe's payload, if loaded
+#elif defined(ACK_PL)
+        sts3 = rf24_status(RF24L01_B);  // from last transaction, ACK FIFO only drains since
+        if ((sts3 & ST_TX_FULL) == 0) {
+          // setup first auto-ACK if TX BIFO not full (max 3 ACK_PL)
+          ACK_Buf[ACK_IDX] = ++ack_cnt;
+          // Writes ACK data to the pipe payload will Rx
+          SPI_Write_Buf(RF24L01_B, WR_ACK_PLOAD + pkt->pipe, ACK_Buf, ACK_PL_WIDTH); 
+          STATS_ACK_PL(RF24L01_B, pkt->pipe, ACK_PL_WIDTH);
+        }
+#endif
+
+        // count for the RX packet rate 
+        rx_cnt++;
+        rx_ring_pop(&Rx2_Ring);
+    }
+#ifdef ACK_POOL
+    ACK_B_refill();
+#endif
+}
+
+
+#ifdef RF24_EVT
+/*===============================================
+ *
+ *  IRQ event handlers of nRF24L01p A/B
+ *
+ *===============================================
+ */
+#ifdef TX_STREAM
+const rf24_evt_t RF_A_evt = { nRF24L01_TxStreamDone, nRF24L01_TxStreamFailed,
+#else
+const rf24_evt_t RF_A_evt = { RF_A_sent, RF_A_failed,
+#endif
+#ifdef AUTO_ACK
+                              RF_A_ack_pl };
+#else
+                              0 };
+#endif
+const rf24_evt_t RF_B_evt = { 0, 0, RF_B_rx_ready };  // ACK payloads refilled per RX
+#endif
 
 //#####################################################
 //
 // LED status display debugging invoked by push botton 
+// (key press events, pb_lib: key LED 250ms, then the 
+// value flashed LOOP times, played in the background 
+// by the LED queue; a press drops what is still shown)
 //
 //#####################################################
+#define PB_SHOW(key_led, v)  { led_flash(key_led, 250, 0, 1); \
+                               led_flash(v, LED_ON_MS, LED_OFF_MS, LOOP); }
+
 void PB_DBG(void) {
-  int i;
+    unsigned char ev;
   
-    // simulate RF_A reset case
-    if (KEY1_KIN) {
-        halt_led_toggle = 0;
-        LED_ALL_0;
-        LED1_1;
-        delay_ms(250);
-        // display desired debug status here
-        for (i=0; i<LOOP; i++) {
-          display(mode_a);      // debug info
-        }
-        init_NRF24L01_A();
-        delay_ms(250);
-        LED_ALL_0;
-    }
+    while ((ev = pb_get()) != PB_NONE) {
+        if (!(ev & PB_PRESS)) continue;     // releases not used
+        led_clear();
 
-    // simulate RF_B reset case
-    if (KEY2_KIN) {
-        halt_led_toggle = 0;
-        LED_ALL_0;
-        LED2_1;
-        delay_ms(250);
-        // display desired debug status here
-        for (i=0; i<LOOP; i++) {
-          display(mode_b);      // debug info
-        }
-        init_NRF24L01_B();
-        SetRX_Mode(RF24L01_B);  // RF B receive mode only (RF A TX mode only)
-        mode_b = 0;
-        delay_ms(250);
-        LED_ALL_0;
-    }
-    
-    if (KEY3_KIN) {
-        halt_led_toggle = 1;
-        LED_ALL_0;
-        LED3_1;
-        delay_ms(250);
-        // display desired debug status here
-        for (i=0; i<LOOP; i++) {
-          display(mode_a);      // debug info
+        // simulate RF_A reset case
+        if (ev & KEY1_PIN) {
+            halt_led_toggle = 0;
+            PB_SHOW(0x01, mode_a);      // debug info
+            rf24_shadow_reset(RF24L01_A);   // whole map read back
+            init_NRF24L01_A();
         }
 
-        LED_ALL_0;
-        LED3_1;
-        delay_ms(250);
-        for (i=0; i<LOOP; i++) {
-          display(sts1);      // debug info
+        // simulate RF_B reset case
+        if (ev & KEY2_PIN) {
+            halt_led_toggle = 0;
+            PB_SHOW(0x02, mode_b);      // debug info
+            rf24_shadow_reset(RF24L01_B);   // whole map read back
+            init_NRF24L01_B();
+            SetRX_Mode(RF24L01_B);  // RF B receive mode only (RF A TX mode only)
+            mode_b = 0;
         }
-        
-        LED_ALL_0;
-        LED3_1;
-        delay_ms(250);
-        for (i=0; i<LOOP; i++) {
-          display(sts2);      // debug info
-        }
-        
-        LED_ALL_0;
-        LED3_1;
-        delay_ms(250);
-        // display desired debug status here
-        for (i=0; i<LOOP; i++) {
-          display(rt_cnt);      // debug info
+    
+        if (ev & KEY3_PIN) {
+            halt_led_toggle = 1;
+            // display desired debug status here
+            PB_SHOW(0x04, mode_a);      // debug info
+            PB_SHOW(0x04, sts1);
+            PB_SHOW(0x04, sts2);
+            PB_SHOW(0x04, rt_cnt);
+            PB_SHOW(0x04, to_a_cnt);
+            PB_SHOW(0x04, tx_pkt_rate);
+#ifdef RF24_IRQ
+            PB_SHOW(0x04, rf24_irq_line(RF24L01_A)); // debug info (level, edge left pending)
+#endif
         }
 
-        LED_ALL_0;
-        LED3_1;
-        delay_ms(250);
-        // display desired debug status here
-        for (i=0; i<LOOP; i++) {
-          display(to_a_cnt);      // debug info
-        }
-        
-        LED_ALL_0;
-        LED3_1;
-        delay_ms(250);
-        // display desired debug status here
-        for (i=0; i<LOOP; i++) {
-          display(tx_pkt_rate);      // debug info
-        }
-        
+        if (ev & KEY4_PIN) {
+            halt_led_toggle = 1;
+            // display desired debug status here
+            PB_SHOW(0x08, mode_b);      // debug info
+            PB_SHOW(0x08, sts3);
+            PB_SHOW(0x08, sts4);
+            PB_SHOW(0x08, to_b_cnt);
 #ifdef RF24_IRQ
-        LED_ALL_0;
-        LED3_1;
-        delay_ms(250);
-        // display desired debug status here
-        for (i=0; i<LOOP; i++) {
-          display(is_rf24_irq(RF24L01_A)); // debug info
-        }
+            PB_SHOW(0x08, rf24_irq_line(RF24L01_B)); // debug info (level, edge left pending)
 #endif
-        
-        LED_ALL_0;
-    }
-
-    if (KEY4_KIN) {
-        halt_led_toggle = 1;
-        LED_ALL_0;
-        LED4_1;
-        delay_ms(250);
-        // display desired debug status here
-        for (i=0; i<LOOP; i++) {
-          display(mode_b);      // debug info
         }
+        show(0);
+    }
+}
 
-        LED_ALL_0;
-        LED4_1;
-        delay_ms(250);
-        // display desired debug status here
-        for (i=0; i<LOOP; i++) {
-          display(sts3);      // debug info
-        }
+/*===============================================
+ *
+ *  Scheduler tasks: SCHED_AGAIN while work is 
+ *  left w/o an IRQ edge or deadline to come, 
+ *  else readied by RF24_isr/KA_wake()/TX_pace()
+ *
+ *===============================================
+ */
+#ifdef ENABLE_PRX
+unsigned char PRX_task(void)
+{
+    RF_B_process(&mode_b);      // PRX: RX FIFO -> Rx2_Ring
+    RX_B_consume();             // Rx2_Ring -> application
 
-        LED_ALL_0;
-        LED4_1;
-        delay_ms(250);
-        // display desired debug status here
-        for (i=0; i<LOOP; i++) {
-          display(sts4);      // debug info
-        }
+#ifdef RF24_IRQ
+    if (mode_b != 1 || rx_ring_count(&Rx2_Ring)) return SCHED_AGAIN;
+  #ifdef RF24_EVT
+    if (nRF24L01_EvtPending(RF24L01_B)) return SCHED_AGAIN;     // no edge to come
+  #endif
+#endif
+    return SCHED_IDLE;          // RX_DR edge, tm_rx (or polled)
+}
+#endif
 
-        LED_ALL_0;
-        LED4_1;
-        delay_ms(250);
-        // display desired debug status here
-        for (i=0; i<LOOP; i++) {
-          display(to_b_cnt);      // debug info
-        }
+#ifdef ENABLE_PTX
+unsigned char PTX_task(void)
+{
+    RF_A_process(&mode_a);      // PTX
 
 #ifdef RF24_IRQ
-        LED_ALL_0;
-        LED4_1;
-        delay_ms(250);
-        // display desired debug status here
-        for (i=0; i<LOOP; i++) {
-          display(is_rf24_irq(RF24L01_B)); // debug info
-        }
+  #ifdef RF24_EVT
+    if (nRF24L01_EvtPending(RF24L01_A)) return SCHED_AGAIN;
+  #endif
+  #if defined(RF24_EVT) && defined(TX_STREAM)
+    if (mode_a < 3 && TX_ready()) return SCHED_AGAIN;       // room in TX FIFO, payload due
+  #elif defined(RF24_EVT)
+    if (mode_a == 2 || (mode_a == 0 && TX_ready())) return SCHED_AGAIN;  // on air: wait for TX_DS/MAX_RT
+  #else
+    if (mode_a != 0 || TX_ready()) return SCHED_AGAIN;     // TX_DS/MAX_RT polled, payload due
+  #endif
 #endif
-        
-        LED_ALL_0;
-    }
+    return SCHED_IDLE;          // TX_DS/MAX_RT edge, tm_tx, tm_txp (or polled)
+}
+#endif
+
+unsigned char UI_task(void)
+{
+    PB_DBG();                   // show debug info using push buttons
+    return SCHED_IDLE;          // key edge, key event queued
 }
 
 //@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
@@ -729,32 +1062,115 @@ main()
     init_rf24_irq();      // IRQ Ports
     #warning "init_rd_irq() will be called"
   #endif
+
+  #ifdef RF24_XPORT
+    // SPI port or GPIO per module: forced by -DRF24_XPORT_A/B=RF24_BUS_xxx,
+    // else the fastest one answering (rf24_xport_auto())
+    #ifdef ENABLE_PTX
+      #ifdef RF24_XPORT_A
+    rf24_xport_init(RF24L01_A, RF24_XPORT_A, XP_IRQ);
+      #else
+    rf24_xport_auto(RF24L01_A, XP_IRQ);
+      #endif
+    #endif
+    
+    #ifdef ENABLE_PRX
+      #ifdef RF24_XPORT_B
+    rf24_xport_init(RF24L01_B, RF24_XPORT_B, XP_IRQ);
+      #else
+    rf24_xport_auto(RF24L01_B, XP_IRQ);
+      #endif
+    #endif
+  #endif
+
+  #ifdef RF24_SCK_CAL
+    // fastest SCK each module reads back right at (one step margin)
+    #ifdef ENABLE_PTX
+    nRF24L01_SckCal(RF24L01_A);
+    #endif
+    #ifdef ENABLE_PRX
+    nRF24L01_SckCal(RF24L01_B);
+    #endif
+  #endif
 #else
     // connect to RF24 via GPIO ports
     init_rf24_gpio();
 #endif
 
+    STATS_RESET(RF24L01_A);
+    STATS_RESET(RF24L01_B);
+    
     // Initialize RF24 modules    
 #ifdef ENABLE_PTX     
     init_NRF24L01_A();
 #endif
     
 #ifdef  ENABLE_PRX         
+    rx_ring_init(&Rx2_Ring);
     init_NRF24L01_B();    
     SetRX_Mode(RF24L01_B);  // RF B receive mode only (RF A TX mode only)
 #endif
 
-    while (1) {
-#ifdef  ENABLE_PRX      
-        RF_B_process(&mode_b);      // PRX
+#ifdef RF24_RECOV
+    // TX/RX keep-alive timeouts: tiered recovery, full init the last tier
+  #ifdef ENABLE_PTX
+    rf24_recov_init(RF24L01_A, CONFIG_PTX, init_NRF24L01_A);
+  #endif
+  #ifdef ENABLE_PRX
+    rf24_recov_init(RF24L01_B, CONFIG_PRX, RF_B_reinit);
+  #endif
+#endif
+
+#ifdef RF24_EVT
+  #ifdef ENABLE_PTX
+    nRF24L01_EvtInit(RF24L01_A, &RF_A_evt);
+  #endif
+  #ifdef ENABLE_PRX
+    nRF24L01_EvtInit(RF24L01_B, &RF_B_evt);
+  #endif
+#endif
+
+    // tasks by priority: PRX draining ahead of PTX loading, debug UI last
+    sched_init();
+#ifdef ENABLE_PRX
+    sched_add(TASK_PRX, PRX_task, RF_POLLED(RF24L01_B));
+  #ifdef RF24_IRQ
+    rf24_irq_sched(RF24L01_B, SCHED_BIT(TASK_PRX));
+  #endif
 #endif
-        
 #ifdef ENABLE_PTX
-        RF_A_process(&mode_a);      // PTX
+    sched_add(TASK_PTX, PTX_task, RF_POLLED(RF24L01_A));
+  #ifdef RF24_IRQ
+    rf24_irq_sched(RF24L01_A, SCHED_BIT(TASK_PTX));
+  #endif
 #endif
+#if 1
+    sched_add(TASK_UI, UI_task, 0);
+#endif
+
+    tm_start(&tm_rate, TM_SEC, TM_SEC, RATE_tick);   // rate window
+#ifdef RF24_IRQ
+    init_pb_evt(1, SCHED_BIT(TASK_UI));     // key press edges via RF24_isr, wake tm_idle()
+#else
+    init_pb_evt(0, SCHED_BIT(TASK_UI));     // no PORT1 ISR: keys sampled every PB_SCAN_MS
+#endif
+#if TX_PERIOD
+    tm_start(&tm_txp, TX_PERIOD/TM_TIME_MS, TX_PERIOD/TM_TIME_MS, TX_pace);
+#endif
+    
+    while (1) {
+        tm_run();                   // deadline timers, callbacks ready tasks
         
-#if 1        
-        PB_DBG();   // show debug info using push buttons
+        if (sched_run()) continue;  // highest priority task ready ran
+
+#ifdef LPM_IDLE
+        // nothing ready until an RF24 IRQ, a timer deadline or a key press ?
+        _BIC_SR(GIE);
+        if (!sched_pending()) {
+            tm_idle();      // LPM0 until IRQ/deadline, GIE on again
+        } else {
+            _BIS_SR(GIE);
+        }
 #endif
     }
 }
@@ -5,18 +5,126 @@
 // #################################################################
 #include <msp430f149.h>
 #include "../device_lib/pb_lib.h"
+#include "../device_lib/timer_lib.h"
+#include "../device_lib/sched_lib.h"
+
+volatile unsigned char pb_ifg;      // key edges latched by the PORT1_VECTOR ISR
+unsigned char pb_rdy;               // sched_lib ready bits of the event consumer
+
+static unsigned char pb_q[PB_Q_SIZE];
+static unsigned char pb_head;       // next event to queue
+static unsigned char pb_tail;       // next event to take
+static unsigned char pb_edge;       // 1: press edges interrupt, scan stops when all up
+static unsigned char pb_raw;        // last sample, KEY_PINS bits down
+static unsigned char pb_cnt;        // samples in a row equal to pb_raw
+static unsigned char pb_keys;       // debounced, KEY_PINS bits down
+static tm_timer_t pb_tm;
 
 //=========================== MSP430 Port IO setup ==========================================
 //    PxDIR 0/1: Input/Output
 //    PxSEL 0/1: default function disabled/enabled
 //    PxIE  0/1: disable/enable interrupt;
 //    PxOUT 0/1: output low/high
-//===========================================================================================    
+//===========================================================================================
 
 // initialize push botton port inputs
 void init_pb(void) {
     // PB_SW Inputs
     P1DIR &= ~(BIT0 + BIT1 + BIT2 + BIT3);  // reset to 0 as Input, P1.0~3, KEY1~KEY4, active low
     P1SEL &= ~(BIT0 + BIT1 + BIT2 + BIT3);  // reset to GPIO mode
-    P1IE  &= ~(BIT0 + BIT1 + BIT2 + BIT3);  // disable all pb.0~3 interrupts   
-}
\ No newline at end of file
+    P1IE  &= ~(BIT0 + BIT1 + BIT2 + BIT3);  // disable all pb.0~3 interrupts
+}
+
+// queue one event per key changed, oldest kept if full
+static void pb_put(unsigned char chg, unsigned char keys)
+{
+    unsigned char bit;
+
+    for (bit = BIT0; bit & KEY_PINS; bit <<= 1) {
+        if (!(chg & bit)) continue;
+        if ((unsigned char)(pb_head - pb_tail) == PB_Q_SIZE) return;
+        pb_q[pb_head++ & PB_Q_MASK] = bit | ((keys & bit) ? PB_PRESS : PB_RELEASE);
+        sched_ready(pb_rdy);
+    }
+}
+
+// press edges (hi/lo) raise PORT1 interrupts again
+static void pb_arm(void)
+{
+    P1IES |= KEY_PINS;                      // Hi/lo edge, active low
+    P1IFG &= ~KEY_PINS;                     // IFG cleared
+    P1IE  |= KEY_PINS;                      // interrupts enabled
+}
+
+// pb_tm: sample the keys (one port read), take a state seen PB_STABLE
+// times in a row; w/ edges, all keys up for good stops the sampling
+static void pb_scan(tm_timer_t *t)
+{
+    unsigned char raw = ~P1IN & KEY_PINS;
+
+    if (raw != pb_raw) {
+        pb_raw = raw;
+        pb_cnt = 1;
+        return;
+    }
+    if (pb_cnt < PB_STABLE && ++pb_cnt == PB_STABLE) {
+        pb_put(raw ^ pb_keys, raw);
+        pb_keys = raw;
+    }
+
+    if (pb_edge && pb_cnt == PB_STABLE && !pb_keys) {
+        pb_arm();
+        if (~P1IN & KEY_PINS) {             // pressed meanwhile, its edge cleared
+            P1IE &= ~KEY_PINS;
+            return;
+        }
+        tm_stop(t);
+    }
+}
+
+/**************************************************
+Function: init_pb_evt();
+
+Description:
+  Start the key events. 'edge' 1: the key press edges
+  interrupt (PORT1_VECTOR ISR, e.g. RF24_isr, masks
+  them, sets pb_ifg & readies 'rdy'), pb_get() starts
+  sampling on them; 0: sampled all the time every
+  PB_SCAN_MS. 'rdy': sched_lib ready bits of the task
+  taking the events (pb_get()), 0: none.
+
+  Needs Timer_A running (init_tm()).
+
+ **************************************************
+ */
+void init_pb_evt(unsigned char edge, unsigned char rdy)
+{
+    pb_head = pb_tail = 0;
+    pb_raw = pb_keys = 0;
+    pb_cnt = PB_STABLE;
+    pb_edge = edge;
+    pb_ifg = 0;
+    pb_rdy = rdy;
+
+    if (edge) {
+        pb_arm();
+    } else {
+        tm_start(&pb_tm, PB_SCAN_MS / TM_TIME_MS, PB_SCAN_MS / TM_TIME_MS, pb_scan);
+    }
+}
+
+//=============================================
+// next key event, PB_NONE if none; a press
+// edge taken by the ISR starts the sampling
+//=============================================
+unsigned char pb_get(void)
+{
+    if (pb_ifg) {
+        pb_ifg = 0;                         // edges masked until pb_arm()
+        if (pb_tm.state != TM_ARMED) {
+            tm_start(&pb_tm, PB_SCAN_MS / TM_TIME_MS, PB_SCAN_MS / TM_TIME_MS, pb_scan);
+        }
+    }
+    if (pb_head == pb_tail) return PB_NONE;
+    return pb_q[pb_tail++ & PB_Q_MASK];
+}
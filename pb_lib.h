@@ -2,6 +2,11 @@
 //
 // MSP430 Push Button Inputs
 //
+// Key events (press/release) debounced by a deadline timer (pb_tm) in
+// main loop context: w/ edge interrupts the keys are only sampled from
+// the first press edge on until all keys are up again, else sampled all
+// the time every PB_SCAN_MS.
+//
 //==============================================================================
 #ifndef _PB_LIB_H_
 #define _PB_LIB_H_
@@ -12,8 +17,48 @@
 #define KEY2_KIN    !(P1IN & BIT1)		// KEY2: p1.1, active low
 #define KEY3_KIN    !(P1IN & BIT2)		// KEY3: p1.0, active low
 #define KEY4_KIN    !(P1IN & BIT3)		// KEY4: p1.1, active low
+#define KEY_PINS    (BIT0 + BIT1 + BIT2 + BIT3)  // KEY1~KEY4 as bits mask
+
+#define KEY1_PIN    BIT0                // event key bits (KEY_PINS)
+#define KEY2_PIN    BIT1
+#define KEY3_PIN    BIT2
+#define KEY4_PIN    BIT3
+
+//-----------------------------------------------------------------------
+//
+// Key events: one KEY_PINS bit | PB_PRESS/PB_RELEASE
+//
+//-----------------------------------------------------------------------
+#define PB_NONE     0x00    // no event queued
+#define PB_PRESS    0x10    // key went down
+#define PB_RELEASE  0x20    // key went up
+
+#define PB_SCAN_MS  10      // key sampling period (msec)
+#define PB_STABLE   3       // same samples in a row to take a key state
+#define PB_Q_SIZE   8       // events queued, power of 2
+#define PB_Q_MASK   (PB_Q_SIZE - 1)
+
+#if (PB_Q_SIZE & PB_Q_MASK)
+ #error "PB_Q_SIZE must be a power of 2"
+#endif
+
+// key edges taken by the PORT1_VECTOR ISR (its P1IE bits masked),
+// set in ISR context only
+extern volatile unsigned char pb_ifg;
+
+// sched_lib ready bits of the key event consumer, set by the ISR on a
+// key edge and by pb_lib on an event queued
+extern unsigned char pb_rdy;
 
 // initialize push botton port inputs
 void init_pb(void);
 
+// start key events (deadline timers running): 'edge' 1: press edges
+// raise PORT1 interrupts (wake LPM0, ISR sets pb_ifg), 0: no PORT1 ISR,
+// keys sampled every PB_SCAN_MS; 'rdy' pb_rdy of the consumer task
+void init_pb_evt(unsigned char edge, unsigned char rdy);
+
+// next key event, PB_NONE if none (call from the main loop)
+unsigned char pb_get(void);
+
 #endif // _PB_LIB_H_
@@ -0,0 +1,196 @@
+// #################################################################
+//
+// RF24 ACK Payload Pool Routines (ACK_POOL)
+//
+// A PTX sends a run of packets to one pipe (one, or as many as its
+// TX FIFO held when TX_ADDR moves on), then goes on to the next pipe.
+// Expected ahead: the rest of the current run, then runs as long as
+// the last one along the successor of each pipe as last seen. Slots
+// go to the first receptions in that order w/o a payload loaded yet.
+// Before any reception the PTX is expected to walk the served pipes
+// round robin from the lowest one, one packet each.
+//
+// head/tail per pipe are free running counters as in rf24_ring.c,
+// all of the pool runs in the PRX consumer context (no ISR).
+//
+// #################################################################
+#include "../device_lib/rf24_if_cfg.h"  // interfaced with SPI or GPIO ports
+#include "../device_lib/rf24_ackpl.h"
+
+#ifdef ACK_POOL
+
+#include "../device_lib/rf24_stats.h"
+
+//=============================================
+// served pipe after 'p' (round robin), 'p' if
+// the only one
+//=============================================
+static unsigned char ack_pool_rr(unsigned char pipes, unsigned char p)
+{
+    unsigned char i;
+
+    for (i = 0; i < 6; i++) {
+        p = (p + 1) % 6;
+        if (pipes & (1 << p)) break;
+    }
+    return p;
+}
+
+//=============================================
+// empty the pool, 'pipes' served
+//=============================================
+void ack_pool_init(ack_pool_t *ap, unsigned char pipes)
+{
+    unsigned char p;
+
+    ap->pipes = pipes;
+    ap->used = 0;
+    ap->miss = 0;
+    ap->last = 0xff;
+    ap->run = 0;
+    ap->run_len = 1;
+    for (p = 0; p < 6; p++) {
+        ap->slots[p] = 0;
+        ap->head[p] = 0;
+        ap->tail[p] = 0;
+        ap->succ[p] = ack_pool_rr(pipes, p);
+    }
+}
+
+//=============================================
+// # of payloads 'pipe' can still queue
+//=============================================
+unsigned char ack_pool_room(ack_pool_t *ap, int pipe)
+{
+    return ACK_POOL_DEPTH - (unsigned char)(ap->head[pipe] - ap->tail[pipe]);
+}
+
+//=============================================
+// queue a copy for 'pipe', 0 if full
+//=============================================
+int ack_pool_put(ack_pool_t *ap, int pipe, unsigned char *buf, unsigned char len)
+{
+    ack_pl_t *e;
+    unsigned char i;
+
+    if (!ack_pool_room(ap, pipe)) return 0;
+    if (len > ACK_POOL_WIDTH) len = ACK_POOL_WIDTH;
+
+    e = &ap->q[pipe][ap->head[pipe] & ACK_POOL_MASK];
+    for (i = 0; i < len; i++) {
+        e->data[i] = buf[i];
+    }
+    e->len = len;
+    ap->head[pipe]++;
+    return 1;
+}
+
+//=============================================
+// packet received on 'pipe'
+//=============================================
+void ack_pool_rx(ack_pool_t *ap, int pipe)
+{
+    if (pipe == ap->last) {
+        if (ap->run != 0xff) ap->run++;
+    } else {
+        if (ap->last < 6) {
+            ap->succ[ap->last] = pipe;
+            ap->run_len = ap->run;
+        }
+        ap->last = pipe;
+        ap->run = 1;
+    }
+
+    if (ap->slots[pipe]) {
+        ap->slots[pipe]--;      // went out w/ the ACK
+        ap->used--;
+    } else if (++ap->miss == 0) {
+        ap->miss--;             // saturated
+    }
+}
+
+//=============================================
+// pipe of the first reception expected w/o a
+// payload loaded, -1 if none queued for the
+// next ACK_POOL_AHEAD receptions
+//=============================================
+static int ack_pool_next(ack_pool_t *ap)
+{
+    unsigned char held[6];
+    unsigned char p, q, left, n;
+
+    for (p = 0; p < 6; p++) {
+        held[p] = ap->slots[p];
+    }
+    if (ap->last < 6) {
+        q = ap->last;
+        left = (ap->run < ap->run_len) ? ap->run_len - ap->run : 0;
+    } else {
+        q = ack_pool_rr(ap->pipes, 5);      // lowest served pipe
+        left = ap->run_len;
+    }
+
+    for (n = 0; n < ACK_POOL_AHEAD; n++) {
+        if (left == 0) {
+            q = ap->succ[q];
+            left = ap->run_len;
+        }
+        left--;
+        if (held[q]) {
+            held[q]--;          // this one already loaded
+        } else if ((ap->pipes & (1 << q)) && ap->head[q] != ap->tail[q]) {
+            return q;
+        }
+    }
+    return -1;
+}
+
+/**************************************************
+Function: ack_pool_fill();
+
+Description:
+  Load queued ACK payloads into the free TX FIFO slots
+  of PRX module 'nrf24', pipe expected next first. A
+  STATUS w/ TX_FULL (chip ahead of the count) stops it,
+  the payload stays queued.
+
+input:
+  nrf24: nRF24L01P module - 0/1: A/B
+
+return: # of payloads written
+
+ **************************************************
+ */
+int ack_pool_fill(int nrf24, ack_pool_t *ap)
+{
+    int p, n = 0;
+    ack_pl_t *e;
+
+    while (ap->used < ACK_POOL_SLOTS && (p = ack_pool_next(ap)) >= 0) {
+        e = &ap->q[p][ap->tail[p] & ACK_POOL_MASK];
+        if (SPI_Write_Buf(nrf24, WR_ACK_PLOAD + p, e->data, e->len) & ST_TX_FULL) break;
+        STATS_ACK_PL(nrf24, p, e->len);
+        ap->tail[p]++;
+        ap->slots[p]++;
+        ap->used++;
+        n++;
+    }
+    return n;
+}
+
+//=============================================
+// FIFO_STATUS read elsewhere: TX FIFO empty,
+// no payload loaded
+//=============================================
+void ack_pool_fifo(ack_pool_t *ap, unsigned char fifo)
+{
+    unsigned char p;
+
+    if (!(fifo & FF_TX_EMPTY)) return;
+    for (p = 0; p < 6; p++) {
+        ap->slots[p] = 0;
+    }
+    ap->used = 0;
+}
+
+#endif // ACK_POOL
@@ -0,0 +1,86 @@
+// #################################################################
+//
+// RF24 ACK Payload Pool Headfile (ACK_POOL)
+//
+// PRX side scheduler of the 3 TX FIFO slots shared by the ACK
+// payloads of all pipes. The application queues payloads per pipe
+// (ack_pool_put()), ack_pool_fill() moves them into the free slots
+// in the order the pipes are expected to receive next. Receptions
+// (ack_pool_rx()) release the slot of their pipe and teach the pool
+// the order the PTX walks the pipes in.
+//
+// Slots held are counted here, the chip is not asked: a packet on a
+// pipe w/ a payload loaded takes it along w/ its ACK. FIFO_STATUS
+// TX_EMPTY (ack_pool_fifo()) puts the count back in step.
+//
+// #################################################################
+#ifndef _RF24_ACKPL_H_
+#define _RF24_ACKPL_H_
+
+#include "../device_lib/rf24_lib.h"
+
+#ifndef ACK_POOL_DEPTH
+ #define ACK_POOL_DEPTH  2      // payloads queued per pipe, power of 2 (<= 128)
+#endif
+#define ACK_POOL_MASK   (ACK_POOL_DEPTH - 1)
+
+#if (ACK_POOL_DEPTH & ACK_POOL_MASK) || (ACK_POOL_DEPTH > 128)
+ #error "ACK_POOL_DEPTH must be a power of 2 up to 128"
+#endif
+
+#ifndef ACK_POOL_WIDTH
+ #define ACK_POOL_WIDTH  8      // max ACK payload bytes kept per entry (<= 32)
+#endif
+
+#define ACK_POOL_SLOTS  3       // TX FIFO depth
+#define ACK_POOL_AHEAD  6       // receptions looked ahead for a slot to load
+
+//***************************************************
+//
+// one queued ACK payload
+//
+//***************************************************
+typedef struct {
+    unsigned char len;
+    unsigned char data[ACK_POOL_WIDTH];
+} ack_pl_t;
+
+//***************************************************
+//
+// ACK payload pool of one PRX module
+//
+//***************************************************
+typedef struct {
+    unsigned char pipes;        // pipes served, bit mask (EN_RXADDR style)
+    unsigned char used;         // TX FIFO slots loaded, sum of 'slots'
+    unsigned char slots[6];     // TX FIFO slots loaded per pipe
+    unsigned char last;         // pipe of the last reception, 0xff: none yet
+    unsigned char run;          // receptions of 'last' in a row (saturated)
+    unsigned char run_len;      // length of the run before, expected again
+    unsigned char succ[6];      // pipe whose run followed the pipe's last run
+    unsigned char head[6];      // next entry to queue (application)
+    unsigned char tail[6];      // next entry to load (ack_pool_fill())
+    unsigned int  miss;         // receptions w/ no payload loaded for the pipe
+    ack_pl_t q[6][ACK_POOL_DEPTH];
+} ack_pool_t;
+
+// empty the pool, 'pipes' served (TX FIFO flushed)
+void ack_pool_init(ack_pool_t *ap, unsigned char pipes);
+
+// # of payloads 'pipe' can still queue
+unsigned char ack_pool_room(ack_pool_t *ap, int pipe);
+
+// queue a copy of 'len' bytes for 'pipe', 0 if its queue is full
+int ack_pool_put(ack_pool_t *ap, int pipe, unsigned char *buf, unsigned char len);
+
+// packet received on 'pipe' (RX FIFO order), its ACK took a payload if one was loaded
+void ack_pool_rx(ack_pool_t *ap, int pipe);
+
+// load queued payloads into the free TX FIFO slots of module 'nrf24',
+// pipe expected next first, returns # of payloads written
+int ack_pool_fill(int nrf24, ack_pool_t *ap);
+
+// FIFO_STATUS 'fifo' read by the application: TX FIFO empty resyncs the count
+void ack_pool_fifo(ack_pool_t *ap, unsigned char fifo);
+
+#endif // _RF24_ACKPL_H_
@@ -5,7 +5,7 @@
 // #################################################################
 #include "../device_lib/rf24_if_cfg.h"  // interfaced with SPI or GPIO ports
 
-#ifndef _RF24_SPI_        // interfaced via GPIO port
+#if !defined(_RF24_SPI_) || defined(RF24_XPORT)  // via GPIO port (or picked at run time)
 
 #include <msp430f149.h>
 #include "../device_lib/rf24_gpio.h"
@@ -42,46 +42,150 @@ void init_rf24_gpio(void)
     P5SEL = 0x00;    
 }
 
+//===========================================================================================
+// Pins of one module only, the other module's port bits left as they are
+// (RF24_XPORT: this module taken from its USART, see rf24_xport.c)
+//===========================================================================================
+void init_rf24_gpio_A(void)
+{
+    P4SEL &= ~(BIT4 + BIT5);                            // P4.4:CE, P4.5:CSN
+    P4DIR |= (BIT4 + BIT5);
+    
+    P5SEL &= ~(RF24L01_A_SCK_BIT + BIT1 + BIT2);        // P5.1~3 off USART1
+    P5DIR |= (RF24L01_A_SCK_BIT + RF24L01_A_MOSI_BIT);  // SCK, MOSI O/P
+    P5DIR &= ~(1 << RF24L01_A_MISO_NO);                 // MISO I/P
+    RF24L01_A_SCK_0;
+}
+
+void init_rf24_gpio_B(void)
+{
+    P4SEL &= ~BIT6;                                     // P4.6:CE
+    P4DIR |= BIT6;
+    
+    P3SEL &= ~(BIT0 + BIT1 + BIT2 + BIT3);              // P3.1~3 off USART0
+    P3DIR |= (BIT0 + RF24L01_B_SCK_BIT + RF24L01_B_MOSI_BIT);  // CSN, SCK, MOSI O/P
+    P3DIR &= ~(1 << RF24L01_B_MISO_NO);                 // MISO I/P
+    RF24L01_B_SCK_0;
+}
+
+//===========================================================================================
+// One byte 'out' on the pins of module X (A/B), MSB first, read back into
+// 'in'. Fully unrolled, per bit:
+//   1) one write of the shared port: SCK low (the slave shifts its next
+//      MISO bit out) with MOSI = bit, 'lo'/'hi' carry the other port bits
+//   2) one write: SCK high, the slave samples MOSI
+//   3) MISO shifted into 'in' in place, w/o a test
+// SCK is left high after the last bit, the next byte's first write (or
+// the caller) drops it.
+//===========================================================================================
+#define GPIO_BIT(X, out, in, k)                                         \
+    o = ((out) & (1 << (k))) ? hi : lo;                                 \
+    RF24L01_##X##_OUT = o;                                              \
+    RF24L01_##X##_OUT = o | RF24L01_##X##_SCK_BIT;                      \
+    in = (in << 1) | ((RF24L01_##X##_IN >> RF24L01_##X##_MISO_NO) & 1);
+
+#define GPIO_BYTE(X, out, in)                                           \
+    GPIO_BIT(X, out, in, 7) GPIO_BIT(X, out, in, 6)                     \
+    GPIO_BIT(X, out, in, 5) GPIO_BIT(X, out, in, 4)                     \
+    GPIO_BIT(X, out, in, 3) GPIO_BIT(X, out, in, 2)                     \
+    GPIO_BIT(X, out, in, 1) GPIO_BIT(X, out, in, 0)
+
+/************************************************** 
+Function: gpio_a_xfer(), gpio_b_xfer(); 
+ 
+Description: 
+  One SPI burst transaction on RF24 A/B: command byte 'cmd' 
+  followed by 'len' data bytes from 'tx' (0s if tx is 0), 
+  bytes read back stored into 'rx' (ignored if rx is 0). 
+  Same as spi1_xfer()/spi0_xfer()
+
+  The port bits besides SCK/MOSI are taken once (CSN is low
+  already), nothing else may drive that port meanwhile.
+
+return: nRF24L01 STATUS, read during 'cmd'
+
+ **************************************************
+ */
+unsigned char gpio_a_xfer(unsigned char cmd, unsigned char *tx, unsigned char *rx, unsigned char len)
+{
+    unsigned char lo = RF24L01_A_OUT & ~(RF24L01_A_SCK_BIT | RF24L01_A_MOSI_BIT);
+    unsigned char hi = lo | RF24L01_A_MOSI_BIT;
+    unsigned char o, data, status = 0, in = 0;
+
+    GPIO_BYTE(A, cmd, status);
+    while (len--) {
+        data = tx ? *tx++ : 0;
+        GPIO_BYTE(A, data, in);
+        if (rx) {
+            *rx++ = in;
+        }
+    }
+    RF24L01_A_OUT = lo;     // SCK low
+    return (status);
+}
+
+unsigned char gpio_b_xfer(unsigned char cmd, unsigned char *tx, unsigned char *rx, unsigned char len)
+{
+    unsigned char lo = RF24L01_B_OUT & ~(RF24L01_B_SCK_BIT | RF24L01_B_MOSI_BIT);
+    unsigned char hi = lo | RF24L01_B_MOSI_BIT;
+    unsigned char o, data, status = 0, in = 0;
+
+    GPIO_BYTE(B, cmd, status);
+    while (len--) {
+        data = tx ? *tx++ : 0;
+        GPIO_BYTE(B, data, in);
+        if (rx) {
+            *rx++ = in;
+        }
+    }
+    RF24L01_B_OUT = lo;     // SCK low
+    return (status);
+}
+
 /************************************************** 
-Function: GPIO_RW(); 
+Function: gpio_a_xfer_sg(), gpio_b_xfer_sg(); 
  
 Description: 
-  Writes one byte to nRF24L01, and return the byte read 
-  from nRF24L01 during write, according to SPI protocol
+  Write burst on RF24 A/B: command byte 'cmd' followed by
+  the bytes of 'nseg' segments (0s for a segment w/o ptr),
+  one port setup for all. Same as spi1_xfer_sg()/spi0_xfer_sg()
 
-input:
-  nrf24: nRF24L01P module - 0/1: A/B
+return: nRF24L01 STATUS, read during 'cmd'
 
  **************************************************
  */
-unsigned char GPIO_RW(int nrf24, unsigned char data)
+unsigned char gpio_a_xfer_sg(unsigned char cmd, const rf24_seg_t *seg, int nseg)
 {
-    unsigned char i, temp = 0;
-    for (i = 0; i < 8; i++) // output 8-bit
-    {
-        // output 'uchar', MSB to MOSI
-        if ((data & 0x80) == 0x80) {
-	        nrf24 ? RF24L01_B_MOSI_1 : RF24L01_A_MOSI_1; 
-        }else {
-            nrf24 ? RF24L01_B_MOSI_0 : RF24L01_A_MOSI_0;
+    unsigned char lo = RF24L01_A_OUT & ~(RF24L01_A_SCK_BIT | RF24L01_A_MOSI_BIT);
+    unsigned char hi = lo | RF24L01_A_MOSI_BIT;
+    unsigned char o, data, len, *tx, status = 0, in = 0;
+
+    GPIO_BYTE(A, cmd, status);
+    for (; nseg > 0; nseg--, seg++) {
+        for (tx = seg->ptr, len = seg->len; len; len--) {
+            data = tx ? *tx++ : 0;
+            GPIO_BYTE(A, data, in);
         }
-        data = (data << 1); // shift next bit into MSB..
-        temp <<= 1;
-        if (nrf24) {
-	        RF24L01_B_SCK_1; // Set SCK high..
-            if (RF24L01_B_MISO) {
-                temp++; // capture current MISO bit
-            }
-            RF24L01_B_SCK_0; // ..then set SCK low again
-        } else {
-            RF24L01_A_SCK_1; // Set SCK high..
-            if (RF24L01_A_MISO) {
-                temp++; // capture current MISO bit
-            }
-            RF24L01_A_SCK_0; // ..then set SCK low again
+    }
+    RF24L01_A_OUT = lo;     // SCK low
+    return (status);
+}
+
+unsigned char gpio_b_xfer_sg(unsigned char cmd, const rf24_seg_t *seg, int nseg)
+{
+    unsigned char lo = RF24L01_B_OUT & ~(RF24L01_B_SCK_BIT | RF24L01_B_MOSI_BIT);
+    unsigned char hi = lo | RF24L01_B_MOSI_BIT;
+    unsigned char o, data, len, *tx, status = 0, in = 0;
+
+    GPIO_BYTE(B, cmd, status);
+    for (; nseg > 0; nseg--, seg++) {
+        for (tx = seg->ptr, len = seg->len; len; len--) {
+            data = tx ? *tx++ : 0;
+            GPIO_BYTE(B, data, in);
         }
     }
-    return (temp); // return read uchar
+    RF24L01_B_OUT = lo;     // SCK low
+    return (status);
 }
 
 #endif // _RF24_SPI_
\ No newline at end of file
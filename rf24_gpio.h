@@ -8,11 +8,7 @@
 
 #include <msp430f149.h>
 
-//
-// RF24 Module ID defines
-//
-#define RF24L01_A   0
-#define RF24L01_B   1
+#include "../device_lib/rf24_pins.h"  // module IDs, CE/CSN, IRQ pins
 
 // make compatible to MSP430 SPI1 master mode pin assignment
 // defined: use swap cable connect to SPI1 RF24
@@ -31,10 +27,6 @@
 // First nRF24L01P (A) GPIO configuration for SPI interface 
 //
 //###############################################################################
-#define RF24L01_A_CE_0 		(P4OUT &= ~BIT4)  // RF24 pin 3
-#define RF24L01_A_CE_1 		(P4OUT |= BIT4)
-#define RF24L01_A_CSN_0 	(P4OUT &= ~BIT5)  // RF24 pin 4
-#define RF24L01_A_CSN_1 	(P4OUT |= BIT5)
 #define RF24L01_A_SCK_0 	(P5OUT &= ~BIT3)  // RF24 pin 5
 #define RF24L01_A_SCK_1 	(P5OUT |= BIT3)
 #ifdef SWAP_MIMO  
@@ -43,13 +35,21 @@
  #define RF24L01_A_MISO 	(P5IN & BIT2)     // RF24 pin 7
  #define RF24L01_A_MOSI_0 	(P5OUT &= ~BIT1)  // RF24 pin 6
  #define RF24L01_A_MOSI_1 	(P5OUT |= BIT1)
+ #define RF24L01_A_MOSI_BIT BIT1
+ #define RF24L01_A_MISO_NO  2                 // MISO bit # in P5IN
 #else
   #warning "SWAP_MIMO NOT swapped"
 
  #define RF24L01_A_MISO 	(P5IN & BIT1)     // RF24 pin 7
  #define RF24L01_A_MOSI_0 	(P5OUT &= ~BIT2)  // RF24 pin 6
  #define RF24L01_A_MOSI_1 	(P5OUT |= BIT2)
+ #define RF24L01_A_MOSI_BIT BIT2
+ #define RF24L01_A_MISO_NO  1                 // MISO bit # in P5IN
 #endif
+// SCK/MOSI/MISO share P5: SCK and MOSI set by one port write
+#define RF24L01_A_OUT     P5OUT
+#define RF24L01_A_IN      P5IN
+#define RF24L01_A_SCK_BIT BIT3
 // Note: IRQ pin for reference only
 //#define RF24L01_A_IRQ 	P1.4              // RF24 pin 8
 
@@ -58,19 +58,30 @@
 // Second nRF24L01P (B) GPIO configuration for SPI interface 
 //
 //###############################################################################
-#define RF24L01_B_CE_0 		(P4OUT &= ~BIT6)  // RF24 pin 3
-#define RF24L01_B_CE_1 		(P4OUT |= BIT6)
-#define RF24L01_B_CSN_0 	(P3OUT &= ~BIT0)  // RF24 pin 4
-#define RF24L01_B_CSN_1 	(P3OUT |= BIT0)
 #define RF24L01_B_SCK_0 	(P3OUT &= ~BIT3)  // RF24 pin 5
 #define RF24L01_B_SCK_1 	(P3OUT |= BIT3)
 #define RF24L01_B_MISO 		(P3IN & BIT2)     // RF24 pin 7
 #define RF24L01_B_MOSI_0 	(P3OUT &= ~BIT1)  // RF24 pin 6
 #define RF24L01_B_MOSI_1 	(P3OUT |= BIT1)
+// SCK/MOSI/MISO (and CSN) share P3: SCK and MOSI set by one port write
+#define RF24L01_B_OUT     P3OUT
+#define RF24L01_B_IN      P3IN
+#define RF24L01_B_SCK_BIT BIT3
+#define RF24L01_B_MOSI_BIT BIT1
+#define RF24L01_B_MISO_NO 2                   // MISO bit # in P3IN
 // Note: IRQ pin for reference only
 //#define RF24L01_B_IRQ 	P1.7              // RF24 pin 8
 
 void init_rf24_gpio(void);
-unsigned char GPIO_RW(int nrf24, unsigned char data);
+void init_rf24_gpio_A(void);   // RF24 A pins only (P4.4,5, P5.1~3)
+void init_rf24_gpio_B(void);   // RF24 B pins only (P3.0~3, P4.6)
+
+// per module burst transaction, unrolled bits, pins resolved at compile time
+unsigned char gpio_a_xfer(unsigned char cmd, unsigned char *tx, unsigned char *rx, unsigned char len);
+unsigned char gpio_b_xfer(unsigned char cmd, unsigned char *tx, unsigned char *rx, unsigned char len);
+
+// write burst gathered from 'nseg' segments, see spi0_xfer_sg()/spi1_xfer_sg()
+unsigned char gpio_a_xfer_sg(unsigned char cmd, const rf24_seg_t *seg, int nseg);
+unsigned char gpio_b_xfer_sg(unsigned char cmd, const rf24_seg_t *seg, int nseg);
 
 #endif // _RF24_GPIO_H_
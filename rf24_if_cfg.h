@@ -23,8 +23,11 @@
  * RF24 Interfaced via SPI (or GPIO if not defined )
  * - defined use SPI ports
  * - undefined use GPIO ports
+ *
+ * -DNO_RF24_SPI / -DNO_RF24_IRQ turn these off from the command line
+ * (host/Makefile builds every combination)
  */
-#if 1
+#ifndef NO_RF24_SPI
 //#####################################################################
 
   #define _RF24_SPI_  // interfaced with SPI port (via GPIO if undefined)
@@ -35,7 +38,7 @@
   // << RF24 IRQ (PIN-8) Support >>
   //
   //---------------------------------------
-  #if 1
+  #ifndef NO_RF24_IRQ
     #define RF24_IRQ   // RF24 IRQ support 
     #warning RF24_IRQ is ENABLED" 
 
@@ -45,13 +48,74 @@
     #endif
   #endif
 
+  //---------------------------------------
+  //
+  // << Asynchronous SPI Transaction >>
+  // TX payload clocked out by the USART RX ISRs
+  // while the superloop serves the other radio.
+  // Off: at SMCLK/2 one ISR per byte costs more
+  // than the polled burst (host bench *_async),
+  // wins from SCK = SMCLK/8 on, e.g. long
+  // wiring (host bench *_div8: +14% SPI polled,
+  // +5% IRQ, about twice that at SMCLK/16)
+  //
+  //---------------------------------------
+  #if ZERO
+    #define RF24_SPI_ASYNC   // spi_xfer_async() support (or -DRF24_SPI_ASYNC)
+  #endif
+  #ifdef RF24_SPI_ASYNC
+    #warning "RF24_SPI_ASYNC is ENABLED"
+  #endif
+
+  //---------------------------------------
+  //
+  // << Run-time Transport Selection >>
+  // rf24_gpio.c linked in as well, SPI port
+  // or GPIO and IRQ pin or STATUS polling
+  // chosen per module at init (rf24_xport.h)
+  //
+  //---------------------------------------
+  #if ZERO
+    #define RF24_XPORT   // (or -DRF24_XPORT)
+  #endif
+  #ifdef RF24_XPORT
+    #warning "RF24_XPORT is ENABLED"
+    #ifdef RF24_SPI_ASYNC
+      #undef RF24_SPI_ASYNC   // TX payload may be bit-banged
+      #warning "RF24_SPI_ASYNC is DISABLED by RF24_XPORT"
+    #endif
+  #endif
+
   // << Available 8MHz SMCLK Divider >>
   //
   // Note: This devider won't affect TA0
   // MSP430 maximum SPI clock is SMCLK/2 in master mode
+  // (UxBR < 2 not allowed), nRF24L01+ takes up to 10MHz
+  // Per module at run time: spi_set_div()
+  //
+  #ifndef CLKDIV
+    #define CLKDIV    0x02      // SPI UCLK = SMCLK/CLKDIV, boot value (or -DCLKDIV=n)
+  #endif
+  #define CLKDIV_MIN  0x02      // fastest UxBR of the USART in master mode
+  #define CLKDIV_MAX  0x04      // nRF24L01_SckCal() starts here
+
+  //---------------------------------------
+  //
+  // << SCK Divider Calibration >>
+  // fastest divider w/ good TX_ADDR/ADDR_P0
+  // read back, one step margin, per module
+  // at init (nRF24L01_SckCal())
   //
-  #define CLKDIV    0x02        // SPI UCLK = SMCLK/CLKDIV
+  //---------------------------------------
+  #ifndef NO_RF24_SCK_CAL
+    #define RF24_SCK_CAL
+    #warning "RF24_SCK_CAL is ENABLED"
+  #endif
+
+#endif
 
+#if defined(RF24_XPORT) && !defined(_RF24_SPI_)
+  #undef RF24_XPORT     // GPIO only image
 #endif
 
 #endif // _RF24_IF_CFG_H_
\ No newline at end of file
@@ -7,6 +7,404 @@
  */
 #include "../device_lib/rf24_lib.h"
 
+//****************************************************************
+//
+// Shadow register file per module
+//
+// - status: STATUS clocked back as first byte of the last transaction
+// - reg[]: last value written/read of the SHW_xxx registers
+// - addr[]: ADDR_P0~5, TX_ADDR as written (addr_len 0: unknown)
+// - tx_on: CE left high by nRF24L01_TxPacket() in PTX mode
+//
+// Only registers the radio never changes by itself are cached;
+// rf24_shadow_reset() when the module state is unknown, the image
+// kept across a soft-reset (nRF24L01_CfgSync()).
+//
+//****************************************************************
+#define SHW_REGS    14      // CONFIG, EN_AA, EN_RXADDR, SETUP_RETR, RF_CH, RF_SETUP,
+                            // RX_PW_P0 ~ RX_PW_P5, DYNPD, FEATURE
+#define SHW_ADDRS   7       // ADDR_P0 ~ ADDR_P5, TX_ADDR
+
+typedef struct {
+    unsigned char status;
+    unsigned int  valid;                // bit n: reg[n] cached
+    unsigned char reg[SHW_REGS];
+    unsigned char addr_len[SHW_ADDRS];
+    unsigned char addr[SHW_ADDRS][5];
+    unsigned char tx_on;
+} rf24_shadow_t;
+
+static rf24_shadow_t rf24_shw[2];       // RF24 A/B
+
+// power-on reset values of the SHW_xxx registers (slot order)
+static const unsigned char shw_por[SHW_REGS] = {
+    0x08, 0x3f, 0x03, 0x03, 0x02, 0x0e,     // RF_SETUP: 0x0f on nRF24L01 (non-p)
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00
+};
+
+// cached register slot of 'reg' (register address), -1 if not cached
+static int shw_slot(unsigned char reg)
+{
+    switch (reg) {
+    case CONFIG:    return 0;
+    case EN_AA:     return 1;
+    case EN_RXADDR: return 2;
+    case SETUP_RETR: return 3;
+    case RF_CH:     return 4;
+    case RF_SETUP:  return 5;
+    case DYNPD:     return 12;
+    case FEATURE:   return 13;
+    default:
+        if (reg >= RX_PW_P0 && reg <= RX_PW_P5) return 6 + (reg - RX_PW_P0);
+        return -1;
+    }
+}
+
+// 1: address 'idx' (reg - ADDR_P0) already programmed as buf/len
+static int shw_addr_same(rf24_shadow_t *shw, int idx, unsigned char *buf, unsigned char len)
+{
+    unsigned char i;
+
+    if (shw->addr_len[idx] != len) return 0;
+    for (i = 0; i < len && shw->addr[idx][i] == buf[i]; i++);
+    return (i == len);
+}
+
+/************************************************** 
+Function: rf24_xact(); 
+ 
+Description: 
+  One SPI transaction: CSN low, command byte 'reg' and 'len'
+  data bytes (see SPI_XFER_A/B), CSN high. The module is
+  resolved once here, the byte (GPIO: bit) loops below are
+  straight-line code for the pins/USART of that module.
+  RF24_XPORT: CSN and transaction of the port the module
+  is on (rf24_xp[], rf24_xport.c).
+
+input:
+  nrf24: nRF24L01P module - 0/1: A/B
+
+return: nRF24L01 STATUS, read during 'reg'
+
+ **************************************************/
+static unsigned char rf24_xact(int nrf24, unsigned char reg, unsigned char *tx, unsigned char *rx, unsigned char len)
+{
+    unsigned char status;
+    
+    SPI_SYNC(nrf24);
+#ifdef RF24_XPORT
+    rf24_xp[nrf24].csn(0);
+    status = rf24_xp[nrf24].xfer(reg, tx, rx, len);
+    rf24_xp[nrf24].csn(1);
+#else
+    if (nrf24) {
+        RF24L01_B_CSN_0;    // CSN low, init SPI transaction
+        status = SPI_XFER_B(reg, tx, rx, len);
+        RF24L01_B_CSN_1;    // CSN high again
+    } else {
+        RF24L01_A_CSN_0;
+        status = SPI_XFER_A(reg, tx, rx, len);
+        RF24L01_A_CSN_1;
+    }
+#endif
+    return status;
+}
+
+#ifndef RF24_SPI_ASYNC
+/************************************************** 
+Function: rf24_xact_sg(); 
+ 
+Description: 
+  rf24_xact() w/ the data bytes gathered from 'nseg'
+  segments (write only, see SPI_XFER_SG_A/B), one CSN
+  frame, one burst
+
+input:
+  nrf24: nRF24L01P module - 0/1: A/B
+
+return: nRF24L01 STATUS, read during 'reg'
+
+ **************************************************/
+static unsigned char rf24_xact_sg(int nrf24, unsigned char reg, const rf24_seg_t *seg, int nseg)
+{
+    unsigned char status;
+    
+    SPI_SYNC(nrf24);
+#ifdef RF24_XPORT
+    rf24_xp[nrf24].csn(0);
+    status = rf24_xp[nrf24].xfer_sg(reg, seg, nseg);
+    rf24_xp[nrf24].csn(1);
+#else
+    if (nrf24) {
+        RF24L01_B_CSN_0;
+        status = SPI_XFER_SG_B(reg, seg, nseg);
+        RF24L01_B_CSN_1;
+    } else {
+        RF24L01_A_CSN_0;
+        status = SPI_XFER_SG_A(reg, seg, nseg);
+        RF24L01_A_CSN_1;
+    }
+#endif
+    return status;
+}
+#endif // RF24_SPI_ASYNC
+
+/************************************************** 
+Function: rf24_shadow_reset(); 
+ 
+Description: 
+  Forget all cached registers of the module, next writes
+  always go out to the nRF24L01
+
+input:
+  nrf24: nRF24L01P module - 0/1: A/B
+
+ **************************************************/
+void rf24_shadow_reset(int nrf24)
+{
+    rf24_shadow_t *shw = &rf24_shw[nrf24];
+    int i;
+
+    shw->valid = 0;
+    shw->tx_on = 0;
+    for (i = 0; i < SHW_ADDRS; i++) {
+        shw->addr_len[i] = 0;
+    }
+}
+
+/************************************************** 
+Function: nRF24L01_PlosReset(); 
+ 
+Description: 
+  PLOS_CNT only restarts on a RF_CH write, which the
+  shadow would skip for the same channel: write it out
+
+input:
+  nrf24: nRF24L01P module - 0/1: A/B
+
+ **************************************************/
+void nRF24L01_PlosReset(int nrf24)
+{
+    rf24_shadow_t *shw = &rf24_shw[nrf24];
+    unsigned char ch;
+    int slot = shw_slot(RF_CH);
+
+    ch = (shw->valid & (1 << slot)) ? shw->reg[slot] : SPI_Read(nrf24, READ_REG + RF_CH);
+    shw->valid &= ~(1 << slot);
+    SPI_RW_Reg(nrf24, WRITE_REG + RF_CH, ch);
+}
+
+/************************************************** 
+Function: nRF24L01_CfgSync(); 
+ 
+Description: 
+  One CONFIG read tells what the module holds before
+  its soft-reset: 0x08 (power-on reset, never written
+  since) the datasheet defaults, the CONFIG cached the
+  image loaded last (kept), else unknown (forgotten,
+  read back by nRF24L01_CfgLoad())
+
+input:
+  nrf24: nRF24L01P module - 0/1: A/B
+
+ **************************************************/
+void nRF24L01_CfgSync(int nrf24)
+{
+    rf24_shadow_t *shw = &rf24_shw[nrf24];
+    unsigned char config;
+    int i;
+
+    shw->status = rf24_xact(nrf24, READ_REG + CONFIG, 0, &config, 1);
+    shw->tx_on = 0;
+
+    if (config == shw_por[0]) {
+        for (i = 0; i < SHW_REGS; i++) {
+            shw->reg[i] = shw_por[i];
+        }
+        shw->valid = (1 << SHW_REGS) - 1;
+        for (i = 0; i < 5; i++) {
+            shw->addr[0][i] = 0xe7;
+            shw->addr[1][i] = 0xc2;
+            shw->addr[TX_ADDR - ADDR_P0][i] = 0xe7;
+        }
+        shw->addr_len[0] = shw->addr_len[1] = shw->addr_len[TX_ADDR - ADDR_P0] = 5;
+        for (i = 2; i < 6; i++) {
+            shw->addr[i][0] = 0xc1 + i;     // LSB, MSBs of ADDR_P1
+            shw->addr_len[i] = 1;
+        }
+    } else if (!(shw->valid & 1) || shw->reg[0] != config) {
+        rf24_shadow_reset(nrf24);
+    }
+}
+
+/************************************************** 
+Function: nRF24L01_CfgLoad(); 
+ 
+Description: 
+  One read-back pass over the profile: each entry read
+  from the module and compared, only registers differing
+  written, each read back after its write (a failed one
+  left out of the image). Warm re-init: CONFIG only
+  written, a register corrupted meanwhile rewritten;
+  power-on: the non-default ones written
+
+input:
+  nrf24: nRF24L01P module - 0/1: A/B
+  cfg: profile table, 'n' entries
+
+return: registers written, -1: a write did not take
+
+ **************************************************/
+int nRF24L01_CfgLoad(int nrf24, const rf24_cfg_t *cfg, int n)
+{
+    rf24_shadow_t *shw = &rf24_shw[nrf24];
+    unsigned char back[5], *want;
+    unsigned char i, len;
+    int slot, idx, wr = 0, bad = 0;
+
+    for (; n > 0; n--, cfg++) {
+        len = cfg->len;
+        want = cfg->buf ? cfg->buf : (unsigned char *)&cfg->val;
+        slot = shw_slot(cfg->reg);
+        idx = (cfg->reg >= ADDR_P0 && cfg->reg <= TX_ADDR) ? cfg->reg - ADDR_P0 : -1;
+
+        shw->status = rf24_xact(nrf24, READ_REG + cfg->reg, 0, back, len);
+        for (i = 0; i < len && back[i] == want[i]; i++);
+        if (i < len) {
+            shw->status = rf24_xact(nrf24, WRITE_REG + cfg->reg, want, 0, len);
+            rf24_xact(nrf24, READ_REG + cfg->reg, 0, back, len);   // taken ?
+            for (i = 0; i < len && back[i] == want[i]; i++);
+            wr++;
+            if (i < len) {
+                bad = 1;
+                if (slot >= 0) shw->valid &= ~(1 << slot);
+                if (idx >= 0) shw->addr_len[idx] = 0;
+                continue;           // left out of the image
+            }
+        }
+
+        if (slot >= 0) {
+            shw->reg[slot] = want[0];
+            shw->valid |= (1 << slot);
+        } else if (idx >= 0) {
+            for (i = 0; i < len; i++) {
+                shw->addr[idx][i] = want[i];
+            }
+            shw->addr_len[idx] = len;
+        }
+    }
+    return bad ? -1 : wr;
+}
+
+#ifdef RF24_SCK_CAL
+#define CAL_ROUNDS  2       // pattern rounds per divider
+
+// TX_ADDR/ADDR_P0 written w/ pattern 'seed' (ADDR_P0 inverted)
+// and read back, 1: all 'aw' bytes the same
+static int sck_cal_check(int nrf24, unsigned char seed, unsigned char aw)
+{
+    static const unsigned char reg[2] = { ADDR_P0, TX_ADDR };
+    unsigned char pat[5], back[5];
+    unsigned char i, r;
+
+    for (r = 0; r < 2; r++) {
+        for (i = 0; i < aw; i++) {
+            pat[i] = (unsigned char)(seed + i * 0x5b);
+            if (r == 0) pat[i] = ~pat[i];
+        }
+        rf24_xact(nrf24, WRITE_REG + reg[r], pat, 0, aw);
+        rf24_xact(nrf24, READ_REG + reg[r], 0, back, aw);
+        for (i = 0; i < aw && pat[i] == back[i]; i++);
+        if (i < aw) return 0;
+    }
+    return 1;
+}
+
+/************************************************** 
+Function: nRF24L01_SckCal(); 
+ 
+Description: 
+  Step the SCK divider from CLKDIV_MAX down, CAL_ROUNDS
+  pattern rounds (0x55/0xaa/0x00/0xff based) each, until
+  one fails or CLKDIV_MIN passed. A failure locks the
+  divider one step above the last passing one (margin).
+  Addresses are saved/restored at CLKDIV_MAX, the shadow
+  (rf24_shw[]) stays valid.
+
+input:
+  nrf24: nRF24L01P module - 0/1: A/B
+
+return: divider locked, 0: none passed (CLKDIV kept)
+
+ **************************************************/
+unsigned char nRF24L01_SckCal(int nrf24)
+{
+    static const unsigned char seed[CAL_ROUNDS] = { 0x55, 0x00 };  // ADDR_P0 inverted: 0xaa, 0xff
+    unsigned char save_p0[5], save_tx[5];
+    unsigned char aw, div, pass = 0;
+    int i;
+
+#ifdef RF24_XPORT
+    if (rf24_xp[nrf24].bus != RF24_BUS_SPI) return 0;
+#endif
+    SPI_SYNC(nrf24);
+    spi_set_div(nrf24, CLKDIV_MAX);     // slowest first: known good reads
+    rf24_xact(nrf24, READ_REG + SETUP_AW, 0, &aw, 1);
+    aw &= 0x03;
+    aw = aw ? aw + 2 : 3;               // 3~5 bytes (0: illegal)
+    rf24_xact(nrf24, READ_REG + ADDR_P0, 0, save_p0, aw);
+    rf24_xact(nrf24, READ_REG + TX_ADDR, 0, save_tx, aw);
+
+    for (div = CLKDIV_MAX; div >= CLKDIV_MIN; div--) {
+        spi_set_div(nrf24, div);
+        for (i = 0; i < CAL_ROUNDS && sck_cal_check(nrf24, seed[i], aw); i++);
+        if (i < CAL_ROUNDS) {
+            if (pass && pass < CLKDIV_MAX) pass++;  // margin step
+            break;
+        }
+        pass = div;
+    }
+
+    spi_set_div(nrf24, CLKDIV_MAX);
+    rf24_xact(nrf24, WRITE_REG + ADDR_P0, save_p0, 0, aw);
+    rf24_xact(nrf24, WRITE_REG + TX_ADDR, save_tx, 0, aw);
+    spi_set_div(nrf24, pass ? pass : CLKDIV);
+    return (pass);
+}
+#endif
+
+/************************************************** 
+Function: rf24_status(); 
+ 
+Description: 
+  STATUS clocked back by the last transaction, no SPI access.
+  Only current if nothing (RX/TX/ACK) happened on air since.
+
+input:
+  nrf24: nRF24L01P module - 0/1: A/B
+
+ **************************************************/
+unsigned char rf24_status(int nrf24)
+{
+    return rf24_shw[nrf24].status;
+}
+
+/************************************************** 
+Function: SPI_Status(); 
+ 
+Description: 
+  Read STATUS with a single NOP byte transaction
+
+input:
+  nrf24: nRF24L01P module - 0/1: A/B
+
+ **************************************************/
+unsigned char SPI_Status(int nrf24)
+{
+    return SPI_Write_Reg(nrf24, NOP);
+}
+
 /************************************************** 
 Function: SPI_Read(); 
  
@@ -20,15 +418,54 @@ input:
 unsigned char SPI_Read(int nrf24, unsigned char reg)
 {
     unsigned char reg_val;
+    int slot;
     
-    nrf24 ? RF24L01_B_CSN_0 : RF24L01_A_CSN_0; // CSN low, initialize SPI communication...
-    SPI_RW(nrf24, reg); // Select register to read from..
-    reg_val = SPI_RW(nrf24, NOP); // ..then read registervalue
-    nrf24 ? RF24L01_B_CSN_1 : RF24L01_A_CSN_1; // CSN high, terminate SPI communication
+    rf24_shw[nrf24].status = rf24_xact(nrf24, reg, 0, &reg_val, 1); // Select register, then read registervalue
+
+    // always read from the module (check()), refresh the cache
+    if ((reg & 0xE0) == READ_REG && (slot = shw_slot(reg)) >= 0) {
+        rf24_shw[nrf24].reg[slot] = reg_val;
+        rf24_shw[nrf24].valid |= (1 << slot);
+    }
     
     return (reg_val); //  return register value
 }
 
+/************************************************** 
+Function: rf24_status_clr(); 
+ 
+Description: 
+  Clears STATUS flags 'flags' (write 1 to clear), the
+  caller serves 'served' (flags plus ones it clears
+  later itself)
+  RF24_IRQ: the IRQ line is level-low, a flag left set
+  raises no new edge. Once all served flags are clear
+  a low line is marked pending; while some are still
+  set it stays low anyway, only a flag outside them
+  (STATUS clocked out before the clear) is marked and
+  the caller's last clear re-checks the line
+
+input:
+  nrf24: nRF24L01P module - 0/1: A/B
+
+return: nRF24L01 status, read before the clear
+
+ **************************************************/
+static unsigned char rf24_status_clr(int nrf24, unsigned char flags, unsigned char served)
+{
+    rf24_shadow_t *shw = &rf24_shw[nrf24];
+    unsigned char status;
+    
+    status = rf24_xact(nrf24, WRITE_REG + STATUS, &flags, 0, 1);
+    shw->status = status & ~(flags & (ST_RX_DR | ST_TX_DS | ST_MAX_RT));
+#ifdef RF24_IRQ
+    if (!(served & ~flags) || (status & ~served & (ST_RX_DR | ST_TX_DS | ST_MAX_RT))) {
+        rf24_irq_recheck(nrf24);
+    }
+#endif
+    return (status);
+}
+
 /************************************************** 
 Function: SPI_RW_Reg(); 
  
@@ -43,10 +480,9 @@ unsigned char SPI_Write_Reg(int nrf24, unsigned char reg)
 {
     unsigned char status;
     
-    nrf24 ? RF24L01_B_CSN_0 : RF24L01_A_CSN_0; // CSN low, init SPI transaction
-    status = SPI_RW(nrf24, reg); // select register
-    nrf24 ? RF24L01_B_CSN_1 : RF24L01_A_CSN_1; // CSN high again
+    status = rf24_xact(nrf24, reg, 0, 0, 0); // select register
     
+    rf24_shw[nrf24].status = status;
     return (status); // return nRF24L01 status uchar
 }
 
@@ -55,19 +491,38 @@ Function: SPI_RW_Reg();
  
 Description: 
   Writes value 'value' to register 'reg'
+  Skipped if the cached register already holds 'value'
+  (STATUS: flags cleared by rf24_status_clr())
 
 input:
   nrf24: nRF24L01P module - 0/1: A/B
 
+return: nRF24L01 status (cached one if skipped)
+
  **************************************************/
 unsigned char SPI_RW_Reg(int nrf24, unsigned char reg, unsigned char value)
 {
+    rf24_shadow_t *shw = &rf24_shw[nrf24];
     unsigned char status;
+    int slot = -1;
+    
+    if (reg == WRITE_REG + STATUS) {
+        return rf24_status_clr(nrf24, value, value);
+    }
+    if ((reg & 0xE0) == WRITE_REG) {
+        slot = shw_slot(reg & 0x1f);
+        if (slot >= 0 && (shw->valid & (1 << slot)) && shw->reg[slot] == value) {
+            return (shw->status);   // already there
+        }
+    }
     
-    nrf24 ? RF24L01_B_CSN_0 : RF24L01_A_CSN_0; // CSN low, init SPI transaction
-    status = SPI_RW(nrf24, reg); // select register
-    SPI_RW(nrf24, value); // ..and write value to it..
-    nrf24 ? RF24L01_B_CSN_1 : RF24L01_A_CSN_1; // CSN high again
+    status = rf24_xact(nrf24, reg, &value, 0, 1); // select register and write value to it..
+    
+    shw->status = status;
+    if (slot >= 0) {
+        shw->reg[slot] = value;
+        shw->valid |= (1 << slot);
+    }
     
     return (status); // return nRF24L01 status uchar
 }
@@ -85,14 +540,11 @@ input:
  **************************************************/
 unsigned char SPI_Read_Buf(int nrf24, unsigned char reg, unsigned char* pBuf, unsigned char chars)
 {
-    unsigned char status, uchar_ctr;
+    unsigned char status;
     
-    nrf24 ? RF24L01_B_CSN_0 : RF24L01_A_CSN_0; // Set CSN low, init SPI tranaction
-    status = SPI_RW(nrf24,reg); // Select register to write to and read status uchar
-    for (uchar_ctr = 0; uchar_ctr < chars; uchar_ctr++) {
-        pBuf[uchar_ctr] = SPI_RW(nrf24,0); //
-    }
-    nrf24 ? RF24L01_B_CSN_1 : RF24L01_A_CSN_1; // Set CSN high
+    status = rf24_xact(nrf24, reg, 0, pBuf, chars); // Select register, read status uchar, then all bytes
+    
+    rf24_shw[nrf24].status = status;
     return (status); // return nRF24L01 status uchar
 }
 
@@ -101,19 +553,31 @@ Function: SPI_Write_Buf();
  
 Description: 
   Writes 'bytes' from pBuff to register 'chars' 
-  Typically used to write TX payload, Rx/Tx address */
+  Typically used to write TX payload, Rx/Tx address
+  Pipe/TX address writes skipped if already programmed */
 /**************************************************/
 unsigned char SPI_Write_Buf(int nrf24, unsigned char reg, unsigned char* pBuf, unsigned char chars)
 {
-    unsigned char status, uchar_ctr;
+    rf24_shadow_t *shw = &rf24_shw[nrf24];
+    unsigned char status, i;
+    int idx = -1;
     
-    nrf24 ? RF24L01_B_CSN_0 : RF24L01_A_CSN_0; // Set CSN low, init SPI tranaction
-    status = SPI_RW(nrf24,reg); // Select register to write to and read status byte
-    for (uchar_ctr = 0; uchar_ctr < chars; uchar_ctr++) // then write all byte in buffer(*pBuf)
-    {
-        SPI_RW(nrf24, *pBuf++);
+    if (reg >= WRITE_REG + ADDR_P0 && reg <= WRITE_REG + TX_ADDR && chars <= 5) {
+        idx = reg - (WRITE_REG + ADDR_P0);
+        if (shw_addr_same(shw, idx, pBuf, chars)) {
+            return (shw->status);   // already there
+        }
+    }
+    
+    status = rf24_xact(nrf24, reg, pBuf, 0, chars); // Select register, read status byte, then write all bytes in buffer(*pBuf)
+    
+    shw->status = status;
+    if (idx >= 0) {
+        for (i = 0; i < chars; i++) {
+            shw->addr[idx][i] = pBuf[i];
+        }
+        shw->addr_len[idx] = chars;
     }
-    nrf24 ? RF24L01_B_CSN_1 : RF24L01_A_CSN_1; // Set CSN high
     return (status); 
 }
 
@@ -122,15 +586,13 @@ unsigned char SPI_Write_Buf(int nrf24, unsigned char reg, unsigned char* pBuf, u
 //****************************************************************************************************/
 void SetRX_Mode(int nrf24)
 {
-    nrf24 ? RF24L01_B_CE_0 : RF24L01_A_CE_0;    // stop radio TX/RX transmission
+    SPI_SYNC(nrf24);
+    RF24_CE_0(nrf24);    // stop radio TX/RX transmission
+    rf24_shw[nrf24].tx_on = 0;
 
-#ifdef RF24_IRQ     
-    SPI_RW_Reg(nrf24, WRITE_REG + CONFIG, 0x3f); // Enable IRQ pin, sel PWR_UP bit, enable CRC(2 bytes) & Prim:RX. RX_DR enabled..
-#else
-    SPI_RW_Reg(nrf24, WRITE_REG + CONFIG, 0x7f); // Disable IRQ pin, set PWR_UP bit, enable CRC(2 bytes) & Prim:RX. RX_DR enabled..
-#endif
+    SPI_RW_Reg(nrf24, WRITE_REG + CONFIG, CONFIG_PRX); // IRQ sources, PWR_UP bit, CRC(2 bytes) & Prim:RX
     
-    nrf24 ? RF24L01_B_CE_1 : RF24L01_A_CE_1; // Set CE pin high to enable radio TX/RX transmission
+    RF24_CE_1(nrf24); // Set CE pin high to enable radio TX/RX transmission
     inerDelay(200); // wait for RX ready
 }
 
@@ -147,42 +609,478 @@ int nRF24L01_RxPacket(int nrf24, unsigned char* rx_buf, unsigned char *size)
     
     *size = 0;
     
-#ifdef RF24_IRQ
+#if defined(RF24_IRQ) && !defined(RF24_EVT)
     // RF24 IRQ ready ?
-    if (!is_rf24_irq(nrf24)) return -1;
+    if (!RF24_IRQ_CHK(nrf24)) return -1;
 #endif
         
-    if ((status = SPI_Read(nrf24, READ_REG + STATUS)) & ST_RX_DR)
+    // payload width, with STATUS clocked back in the same transaction
+    *size = SPI_Read(nrf24, RD_RX_PL_WID); 
+    if ((status = rf24_status(nrf24)) & ST_RX_DR)
     {
-        *size = SPI_Read(nrf24, RD_RX_PL_WID); 
         SPI_Read_Buf(nrf24, RD_RX_PLOAD, rx_buf, *size); // read receive payload from RX_FIFO buffer
         SPI_RW_Reg(nrf24, WRITE_REG + STATUS, ST_RX_DR); // clear RX DR ready flags
         return ((status & ST_RX_P_NO)>>1);  // return pipe # data received
     } else {
+        *size = 0;
         return -1; // no data received
     }
 }
 
+// RX FIFO drain start: STATUS of the first payload with its width, 
+// RX_DR cleared so a packet landing afterwards raises a new IRQ edge
+static unsigned char rx_fifo_first(int nrf24, unsigned char *width)
+{
+    unsigned char status;
+    
+    *width = SPI_Read(nrf24, RD_RX_PL_WID);
+    status = rf24_status(nrf24);
+    if (status & ST_RX_DR) {
+        SPI_RW_Reg(nrf24, WRITE_REG + STATUS, ST_RX_DR); // clear RX DR ready flags
+    }
+    return status;
+}
+
+// read the RX FIFO head payload into pkt, return STATUS of the next one
+static unsigned char rx_fifo_next(int nrf24, rf24_rx_pkt_t *pkt, unsigned char status, unsigned char *width)
+{
+    pkt->pipe = (status & ST_RX_P_NO) >> 1;
+    pkt->len = *width;
+    pkt->ts = get_stamp();
+    SPI_Read_Buf(nrf24, RD_RX_PLOAD, pkt->data, *width); // read receive payload from RX_FIFO buffer
+    
+    *width = SPI_Read(nrf24, RD_RX_PL_WID);  // next one ?
+    return rf24_status(nrf24);
+}
+
+//******************************************************************************************************/
+// int nRF24L01_RxBatch(int nrf24, rf24_rx_pkt_t *pkt, int max)
+// RX all pending packets (up to 'max') until the RX FIFO is empty
+//
+// RX_P_NO of the STATUS clocked back with every RD_RX_PL_WID tells
+// the pipe of the next payload, 111 once the RX FIFO is empty (same as 
+// FIFO_STATUS.RX_EMPTY w/o an extra transaction). RX_DR is cleared 
+// before draining, so a packet landing afterwards raises a new IRQ edge.
+//
+// Packets beyond 'max' are left in the RX FIFO w/o an edge to come, the
+// drain is retried w/o IRQ as in nRF24L01_RxRing() (held RX FIFO).
+//
+// return: # of packets read into pkt[]
+//******************************************************************************************************/
+static unsigned char rx_held[2];    // RX FIFO left non-empty for RF24 A/B
+
+int nRF24L01_RxBatch(int nrf24, rf24_rx_pkt_t *pkt, int max)
+{
+    unsigned char status, width;
+    int n = 0, edge = 0;
+    
+#ifdef RF24_EVT
+    edge = 1;                           // rx_ready of an edge or of the held FIFO
+#elif defined(RF24_IRQ)
+    // RF24 IRQ ready ?
+    if (!(edge = RF24_IRQ_CHK(nrf24)) && !rx_held[nrf24]) return 0;
+#endif
+    
+    edge = edge && !rx_held[nrf24];     // FIFO head is the packet of the edge
+    rx_held[nrf24] = 0;
+    status = rx_fifo_first(nrf24, &width);
+    while ((status & ST_RX_P_NO) != ST_RX_EMPTY) {
+        if (width > 32) {
+            SPI_Write_Reg(nrf24, FLUSH_RX);   // corrupted width: drop RX FIFO
+            break;
+        }
+        if (n >= max) {
+            rx_held[nrf24] = 1;     // pkt[] full: retry next call
+            break;
+        }
+        status = rx_fifo_next(nrf24, &pkt[n++], status, &width);
+    }
+#ifdef RF24_IRQ
+    if (edge && n) pkt[0].ts = rf24_irq_stamp(nrf24);  // first one raised the edge
+#endif
+    return n;
+}
+
+//******************************************************************************************************/
+// int nRF24L01_RxRing(int nrf24, rx_ring_t *ring)
+// RX pending packets into the ring, as nRF24L01_RxBatch()
+//
+// A packet w/o a free slot is left in the RX FIFO (counted in ring 
+// overflow). In RF24_IRQ mode its edge is then gone, so the drain is 
+// also retried w/o IRQ while the ring had been full (RF24_EVT: raised
+// again as rx_ready by nRF24L01_Dispatch()).
+//
+// return: # of packets queued
+//******************************************************************************************************/
+int nRF24L01_RxRing(int nrf24, rx_ring_t *ring)
+{
+    rf24_rx_pkt_t *pkt;
+    unsigned char status, width;
+    int n = 0, edge = 0;
+    
+#ifdef RF24_EVT
+    edge = 1;                           // rx_ready of an edge or of the held FIFO
+#elif defined(RF24_IRQ)
+    // RF24 IRQ ready ?
+    if (!(edge = RF24_IRQ_CHK(nrf24)) && !rx_held[nrf24]) return 0;
+#endif
+    
+    edge = edge && !rx_held[nrf24];     // FIFO head is the packet of the edge
+    rx_held[nrf24] = 0;
+    status = rx_fifo_first(nrf24, &width);
+    while ((status & ST_RX_P_NO) != ST_RX_EMPTY) {
+        if (width > 32) {
+            SPI_Write_Reg(nrf24, FLUSH_RX);   // corrupted width: drop RX FIFO
+            break;
+        }
+        if ((pkt = rx_ring_slot(ring)) == 0) {
+            rx_held[nrf24] = 1;     // ring full: retry next call
+            break;
+        }
+        status = rx_fifo_next(nrf24, pkt, status, &width);
+#ifdef RF24_IRQ
+        if (edge && !n) pkt->ts = rf24_irq_stamp(nrf24);  // first one raised the edge
+#endif
+        rx_ring_put(ring);
+        n++;
+    }
+    return n;
+}
+
+#ifdef RF24_SPI_ASYNC
+static spi_xfer_t tx_pl_xfer[2];   // WR_TX_PLOAD transaction of RF24 A/B
+static unsigned char tx_pl_buf[2][RF24_PL_MAX];  // SG payload staged for the ISR
+
+// 'nseg' segments into one for the ISR (copied to tx_pl_buf unless just one
+// w/ data), total width already checked against RF24_PL_MAX
+static void tx_pl_stage(int nrf24, const rf24_seg_t *seg, int nseg)
+{
+    spi_xfer_t *x = &tx_pl_xfer[nrf24];
+    unsigned char *tx, len;
+
+    if (nseg == 1 && seg->ptr) {
+        x->tx = seg->ptr;
+        x->len = seg->len;
+        return;
+    }
+    x->tx = tx_pl_buf[nrf24];
+    x->len = 0;
+    for (; nseg > 0; nseg--, seg++) {
+        for (tx = seg->ptr, len = seg->len; len; len--) {
+            tx_pl_buf[nrf24][x->len++] = tx ? *tx++ : 0;
+        }
+    }
+}
+
+// TX payload clocked out (ISR context): start TX
+static void tx_pl_done(int nrf24)
+{
+    rf24_shw[nrf24].status = tx_pl_xfer[nrf24].status;
+    RF24_CE_1(nrf24); // enable RF TX/RX
+}
+#endif
+
 //***********************************************************************************************************
 //void nRF24L01_TxPacket(unsigned char * tx_buf)
 //TX a packet for PTX mode
+//
+// CE is left high after the first packet; while TX_ADDR (and ADDR_P0 
+// for Auto.Ack) and CONFIG stay the same the next payload goes out 
+// w/o address writes and CE toggle (Standby-II -> TX)
+//
+// The payload is gathered from 'nseg' segments in one WR_TX_PLOAD 
+// transaction (nRF24L01_TxPacket(): one segment)
+//
+// return 1: sent, 0: payload width (sum of 'len') not 1~32, nothing written
 //**********************************************************************************************************/
-void nRF24L01_TxPacket(int nrf24, unsigned char* tx_addr, int addr_len, unsigned char* tx_buf, int buf_size)
+int nRF24L01_TxPacketSG(int nrf24, unsigned char* tx_addr, int addr_len, const rf24_seg_t *seg, int nseg)
 {
-    nrf24 ? RF24L01_B_CE_0 : RF24L01_A_CE_0; // disble RF TX/RX
-    SPI_Write_Buf(nrf24, WRITE_REG + TX_ADDR, tx_addr, addr_len); // Writes destination TX_Address to nRF24L01
+    rf24_shadow_t *shw = &rf24_shw[nrf24];
+    int i, width = 0;
+
+    for (i = 0; i < nseg; i++) width += seg[i].len;
+    if (width < 1 || width > RF24_PL_MAX) return 0;
 
+    SPI_SYNC(nrf24);
+    if (!shw->tx_on || !shw_addr_same(shw, TX_ADDR - ADDR_P0, tx_addr, addr_len)
 #ifdef AUTO_ACK    
-    SPI_Write_Buf(nrf24, WRITE_REG + ADDR_P0, tx_addr, addr_len); // Writes RX_Addr0 same as TX_Adr for Auto.Ack
+        || !shw_addr_same(shw, 0, tx_addr, addr_len)
 #endif
+        || !(shw->valid & 1) || shw->reg[0] != CONFIG_PTX    // CONFIG (slot 0) changed
+       ) {
+        RF24_CE_0(nrf24); // disble RF TX/RX
+        shw->tx_on = 0;
+        SPI_Write_Buf(nrf24, WRITE_REG + TX_ADDR, tx_addr, addr_len); // Writes destination TX_Address to nRF24L01
+
+#ifdef AUTO_ACK    
+        SPI_Write_Buf(nrf24, WRITE_REG + ADDR_P0, tx_addr, addr_len); // Writes RX_Addr0 same as TX_Adr for Auto.Ack
+#endif
+    }
     
-    SPI_Write_Buf(nrf24, WR_TX_PLOAD, tx_buf, buf_size); // Writes data to TX payload
-    
-#ifdef RF24_IRQ     
-    SPI_RW_Reg(nrf24, WRITE_REG + CONFIG, 0x3e); // Enable RX_DR IRQ pin, sel PWR_UP bit, enable CRC(2 bytes) & Prim:TX..
+#ifdef RF24_SPI_ASYNC
+    // CONFIG first (CE still low), then payload clocked out by the 
+    // USART RX ISR which raises CE when done; caller must keep a single
+    // segment until the next SPI access of this module (SPI_SYNC),
+    // more segments are staged (one copy)
+    SPI_RW_Reg(nrf24, WRITE_REG + CONFIG, CONFIG_PTX); // IRQ sources, PWR_UP bit, CRC(2 bytes) & Prim:TX
+    tx_pl_stage(nrf24, seg, nseg);
+    tx_pl_xfer[nrf24].cmd = WR_TX_PLOAD;
+    tx_pl_xfer[nrf24].rx = 0;
+    tx_pl_xfer[nrf24].done = tx_pl_done;
+    spi_xfer_async(nrf24, &tx_pl_xfer[nrf24]); // Writes data to TX payload, then CE high
+    shw->tx_on = 1;
 #else
-    SPI_RW_Reg(nrf24, WRITE_REG + CONFIG, 0x7e); // Disable IRQ pin, set PWR_UP bit, enable CRC(2 bytes) & Prim:TX..
+
+    shw->status = rf24_xact_sg(nrf24, WR_TX_PLOAD, seg, nseg); // Writes data to TX payload
+    
+    SPI_RW_Reg(nrf24, WRITE_REG + CONFIG, CONFIG_PTX); // IRQ sources, PWR_UP bit, CRC(2 bytes) & Prim:TX
+    
+    RF24_CE_1(nrf24); // enable RF TX/RX
+    shw->tx_on = 1;
 #endif
+    return 1;
+}
+
+int nRF24L01_TxPacket(int nrf24, unsigned char* tx_addr, int addr_len, unsigned char* tx_buf, int buf_size)
+{
+    rf24_seg_t seg;
+    
+    seg.ptr = tx_buf;
+    seg.len = buf_size;
+    return nRF24L01_TxPacketSG(nrf24, tx_addr, addr_len, &seg, 1);
+}
+
+#ifdef TX_STREAM
+//****************************************************************
+//
+// Streaming PTX state per module
+//
+//****************************************************************
+typedef struct {
+    unsigned char queued;                   // payloads written, not yet retired
+    void (*done)(int nrf24, int result);    // per payload outcome
+} tx_stream_t;
+
+static tx_stream_t tx_stream[2];            // RF24 A/B
+
+// oldest queued payload finished with 'result'
+static void tx_stream_retire(int nrf24, int result)
+{
+    tx_stream[nrf24].queued--;
+    if (tx_stream[nrf24].done) tx_stream[nrf24].done(nrf24, result);
+}
+
+//***********************************************************************************************************
+// Reset the stream, queued payloads are forgotten (caller flushes TX FIFO)
+//**********************************************************************************************************/
+void nRF24L01_TxStreamInit(int nrf24, void (*done)(int nrf24, int result))
+{
+    tx_stream[nrf24].queued = 0;
+    tx_stream[nrf24].done = done;
+}
+
+//***********************************************************************************************************
+// Queue one payload into the TX FIFO. TX_ADDR applies to the whole FIFO,
+// so a new destination is only taken once the queued payloads are gone.
+// nRF24L01_TxStreamSG(): payload gathered from segments
+// return 1: queued, 0: TX FIFO full, other destination queued or payload
+// width not 1~32
+//**********************************************************************************************************/
+int nRF24L01_TxStreamSG(int nrf24, unsigned char* tx_addr, int addr_len, const rf24_seg_t *seg, int nseg)
+{
+    tx_stream_t *st = &tx_stream[nrf24];
+    rf24_shadow_t *shw = &rf24_shw[nrf24];
+    
+    if (st->queued >= 3) return 0;
+    if (st->queued && !shw_addr_same(shw, TX_ADDR - ADDR_P0, tx_addr, addr_len)) return 0;
+    
+    if (!nRF24L01_TxPacketSG(nrf24, tx_addr, addr_len, seg, nseg)) return 0; // CE stays high
+    st->queued++;
+    return 1;
+}
+
+int nRF24L01_TxStream(int nrf24, unsigned char* tx_addr, int addr_len, unsigned char* tx_buf, int buf_size)
+{
+    rf24_seg_t seg;
+    
+    seg.ptr = tx_buf;
+    seg.len = buf_size;
+    return nRF24L01_TxStreamSG(nrf24, tx_addr, addr_len, &seg, 1);
+}
+
+#ifdef RF24_EVT
+//***********************************************************************************************************
+// Payloads are retired by the tx_done/tx_failed events. Only a TX FIFO full
+// as counted is checked: room in it means a TX_DS coalesced into an earlier 
+// edge, which would otherwise hold the stream one payload short.
+//**********************************************************************************************************/
+int nRF24L01_TxStreamPoll(int nrf24)
+{
+    tx_stream_t *st = &tx_stream[nrf24];
+    unsigned char fifo;
+    
+    if (st->queued >= 3) {
+        fifo = SPI_Read(nrf24, READ_REG + FIFO_STATUS);
+        if (fifo & FF_TX_EMPTY) {
+            while (st->queued) {
+                tx_stream_retire(nrf24, TX_OK);
+            }
+        } else if (!(fifo & FF_TX_FULL)) {
+            tx_stream_retire(nrf24, TX_OK);
+        }
+    }
+    return st->queued;
+}
+
+//***********************************************************************************************************
+// tx_done (TX_DS) event: the oldest payload is sent. The TX_DS of back to 
+// back payloads may coalesce into one edge, so with more than one queued
+// FIFO_STATUS tells whether the TX FIFO ran empty meanwhile.
+//**********************************************************************************************************/
+void nRF24L01_TxStreamDone(int nrf24)
+{
+    tx_stream_t *st = &tx_stream[nrf24];
+    
+    if (st->queued > 1 && (SPI_Read(nrf24, READ_REG + FIFO_STATUS) & FF_TX_EMPTY)) {
+        while (st->queued) {
+            tx_stream_retire(nrf24, TX_OK);
+        }
+    } else if (st->queued) {
+        tx_stream_retire(nrf24, TX_OK);
+    }
+}
+
+//***********************************************************************************************************
+// tx_failed (MAX_RT) event: the oldest payload failed, the rest flushed
+// (TX halts on MAX_RT, resumed by nRF24L01_Dispatch() clearing it after)
+//**********************************************************************************************************/
+void nRF24L01_TxStreamFailed(int nrf24)
+{
+    tx_stream_t *st = &tx_stream[nrf24];
+    
+    SPI_Write_Reg(nrf24, FLUSH_TX);    
+    if (st->queued) {
+        tx_stream_retire(nrf24, TX_MAX_RT);
+    }
+    while (st->queued) {
+        tx_stream_retire(nrf24, TX_FLUSHED);
+    }
+}
+#else
+//***********************************************************************************************************
+// Retire finished payloads from FIFO_STATUS (+ STATUS clocked back with it):
+// - MAX_RT: oldest payload failed, the rest flushed (TX halts on MAX_RT)
+// - TX_EMPTY: all queued payloads sent
+// - TX_DS: at least the oldest one sent, or TX FIFO no longer full with 3 queued 
+// return: payloads still queued
+//**********************************************************************************************************/
+int nRF24L01_TxStreamPoll(int nrf24)
+{
+    tx_stream_t *st = &tx_stream[nrf24];
+    unsigned char status, fifo;
+    
+    if (!st->queued) return 0;
+    
+    fifo = SPI_Read(nrf24, READ_REG + FIFO_STATUS);
+    status = rf24_status(nrf24);
+    
+    if (status & ST_MAX_RT) {
+        SPI_Write_Reg(nrf24, FLUSH_TX);    
+        SPI_RW_Reg(nrf24, WRITE_REG + STATUS, (ST_TX_DS | ST_MAX_RT)); 
+        if ((status & ST_TX_DS) && st->queued > 1) {
+            tx_stream_retire(nrf24, TX_OK);
+        }
+        tx_stream_retire(nrf24, TX_MAX_RT);
+        while (st->queued) {
+            tx_stream_retire(nrf24, TX_FLUSHED);
+        }
+        return 0;
+    }
+    
+    if (fifo & FF_TX_EMPTY) {
+        while (st->queued) {
+            tx_stream_retire(nrf24, TX_OK);
+        }
+    } else if ((status & ST_TX_DS) || (!(fifo & FF_TX_FULL) && st->queued >= 3)) {
+        tx_stream_retire(nrf24, TX_OK);
+    }
+    
+    if (status & ST_TX_DS) {
+        SPI_RW_Reg(nrf24, WRITE_REG + STATUS, ST_TX_DS); // clear TX_DS for the next one
+    }
+    return st->queued;
+}
+#endif // RF24_EVT
+#endif // TX_STREAM
+
+#ifdef RF24_EVT
+//****************************************************************
+//
+// IRQ event dispatcher
+//
+//****************************************************************
+static const rf24_evt_t rf24_evt_none;          // no handlers
+static const rf24_evt_t *rf24_evt[2];           // RF24 A/B
+
+//***********************************************************************************************************
+// Register the event handlers of the module (0: events only cleared)
+//**********************************************************************************************************/
+void nRF24L01_EvtInit(int nrf24, const rf24_evt_t *evt)
+{
+    rf24_evt[nrf24] = evt;
+}
+
+//***********************************************************************************************************
+// One STATUS read per IRQ edge, turned into tx_done/tx_failed/rx_ready
+//
+// RX_DR and TX_DS are cleared before the handlers run, so anything raised
+// while they drain the RX FIFO or queue the next payload is a new edge.
+// MAX_RT is cleared after tx_failed: the radio would otherwise resume 
+// retransmitting the failed payload before the handler flushed it.
+// A flag raised between the STATUS read and the clear keeps the IRQ line
+// low w/o a new edge, rf24_status_clr() then marks it pending again; the
+// MAX_RT still set for tx_failed does not.
+// An RX FIFO held back by a full ring is raised again as rx_ready w/o
+// an edge, with the pipe from the STATUS nRF24L01_RxRing() left.
+//
+// return: ST_RX_DR/ST_TX_DS/ST_MAX_RT of the events raised, 0: none
+//**********************************************************************************************************/
+unsigned char nRF24L01_Dispatch(int nrf24)
+{
+    const rf24_evt_t *evt = rf24_evt[nrf24] ? rf24_evt[nrf24] : &rf24_evt_none;
+    unsigned char status, ev;
+    
+    if (RF24_IRQ_CHK(nrf24)) {
+        status = SPI_Status(nrf24);
+        ev = status & (ST_RX_DR | ST_TX_DS | ST_MAX_RT);
+        if (ev & (ST_RX_DR | ST_TX_DS)) {
+            rf24_status_clr(nrf24, ev & (ST_RX_DR | ST_TX_DS), ev); // MAX_RT below
+        }
+    } else if (rx_held[nrf24]) {
+        status = rf24_status(nrf24);
+        ev = ST_RX_DR;
+    } else {
+        return 0;
+    }
     
-    nrf24 ? RF24L01_B_CE_1 : RF24L01_A_CE_1; // enable RF TX/RX
+    if ((ev & ST_TX_DS) && evt->tx_done) {
+        evt->tx_done(nrf24);
+    }
+    if (ev & ST_MAX_RT) {
+        if (evt->tx_failed) evt->tx_failed(nrf24);
+        SPI_RW_Reg(nrf24, WRITE_REG + STATUS, ST_MAX_RT); // TX resumes
+    }
+    if ((ev & ST_RX_DR) && evt->rx_ready) {
+        evt->rx_ready(nrf24, (status & ST_RX_P_NO) >> 1);
+    }
+    return ev;
+}
+
+//***********************************************************************************************************
+// 1: nRF24L01_Dispatch() has an event w/o an edge to come (RX FIFO held)
+//**********************************************************************************************************/
+int nRF24L01_EvtPending(int nrf24)
+{
+    return rx_held[nrf24];
 }
+#endif // RF24_EVT
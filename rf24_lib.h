@@ -3,6 +3,7 @@
 
 #include "../device_lib/rf24_if_cfg.h"  // interfaced with SPI or GPIO ports
 #include "../device_lib/timer_lib.h"
+#include "../device_lib/rf24_ring.h"  // rf24_rx_pkt_t, RX packet ring
 
 #ifdef  _RF24_SPI_  // via SPI port
  #include "../device_lib/rf24_spi.h"
@@ -10,11 +11,40 @@
  #include "../device_lib/rf24_gpio.h"
 #endif
 
-// respective SPI port write/read function
+#ifdef RF24_XPORT  // SPI or GPIO port picked per module at run time
+ #include "../device_lib/rf24_xport.h"
+#endif
+
+// respective SPI port burst transaction of RF24 A/B, no module test inside
 #ifdef _RF24_SPI_
- #define SPI_RW  spi_rw     // interface to SPI via SPI ports 
+ #define SPI_XFER_A  spi1_xfer    // RF24 A via SPI1 port
+ #define SPI_XFER_B  spi0_xfer    // RF24 B via SPI0 port
+ #define SPI_XFER_SG_A  spi1_xfer_sg
+ #define SPI_XFER_SG_B  spi0_xfer_sg
+#else
+ #define SPI_XFER_A  gpio_a_xfer  // via GPIO ports instead
+ #define SPI_XFER_B  gpio_b_xfer
+ #define SPI_XFER_SG_A  gpio_a_xfer_sg
+ #define SPI_XFER_SG_B  gpio_b_xfer_sg
+#endif
+
+// CE of RF24 A/B, IRQ edge taken (1: STATUS worth reading)
+#ifdef RF24_XPORT
+ #define RF24_CE_0(nrf24)     rf24_xp[nrf24].ce(0)
+ #define RF24_CE_1(nrf24)     rf24_xp[nrf24].ce(1)
+ #define RF24_IRQ_CHK(nrf24)  rf24_xp[nrf24].irq_pending(nrf24)
 #else
- #define SPI_RW  GPIO_RW    // interface to SPI via GPIO ports instead
+ #define RF24_CE_0(nrf24)     (nrf24 ? RF24L01_B_CE_0 : RF24L01_A_CE_0)
+ #define RF24_CE_1(nrf24)     (nrf24 ? RF24L01_B_CE_1 : RF24L01_A_CE_1)
+ #define RF24_IRQ_CHK(nrf24)  is_rf24_irq(nrf24)
+#endif
+
+// wait for the asynchronous transaction in flight (if any) before
+// touching CSN/CE of the module
+#ifdef RF24_SPI_ASYNC
+ #define SPI_SYNC(nrf24)  spi_xfer_wait(nrf24)
+#else
+ #define SPI_SYNC(nrf24)
 #endif
 
 //@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
@@ -40,27 +70,74 @@
 //
 //        << RF24 Features Configuration >>
 //
+// -DNO_<feature> disables a feature from the command line (host/Makefile)
+//
 // #############################################################################
-#if 1
+#ifndef NO_ENABLE_PTX
   #define ENABLE_PTX      // enable TX on RF_A
   #warning "ENABLE_PTX is ENABLED"
 #endif
 
-#if 1
+#ifndef NO_ENABLE_PRX
   #define ENABLE_PRX      // enable RX on RF_B
   #warning "ENABLE_PRX is ENABLED"
 #endif
 
-#if 1
+#ifndef NO_TX_6_PIPES
   #define TX_6_PIPES      // test TX on all 6 pipes
   #warning "TX_6_PIPES is ENABLED"
 #endif
 
+#ifndef NO_TX_STREAM
+  #define TX_STREAM       // PTX keeps up to 3 payloads in TX FIFO, CE held high
+  #warning "TX_STREAM is ENABLED"
+#endif
+
+// PTX payload pacing in msec (-DTX_PERIOD=n), 0: back to back
+#ifndef TX_PERIOD
+  #define TX_PERIOD       0
+#endif
+
+// tickless LPM0 idle between radio events (or -DLPM_IDLE), RF24_IRQ only
+#if 0
+  #define LPM_IDLE
+#endif
+#ifdef LPM_IDLE
+ #ifndef RF24_IRQ
+  #undef LPM_IDLE
+ #else
+  #warning "LPM_IDLE is ENABLED"
+ #endif
+#endif
+
+// IRQ event dispatcher: TX_DS/MAX_RT/RX_DR all on the IRQ pin, PTX/PRX
+// advanced by nRF24L01_Dispatch() w/o STATUS polling, RF24_IRQ only
+#ifndef NO_RF24_EVT
+ #ifdef RF24_IRQ
+  #define RF24_EVT
+  #warning "RF24_EVT is ENABLED"
+ #endif
+#endif
+
+#ifndef NO_RF24_STATS
+  #define RF24_STATS      // per pipe TX/RX/ACK counters, see rf24_stats.h
+  #warning "RF24_STATS is ENABLED"
+#endif
+
+#ifndef NO_RF24_RECOV
+  #define RF24_RECOV      // tiered TX/RX timeout recovery, see rf24_recov.h
+  #warning "RF24_RECOV is ENABLED"
+#endif
+
 #ifdef  ENABLE_PRX      
- #if 1
+ #ifndef NO_AUTO_ACK
   #define AUTO_ACK        // enable Auto_ACK onfiguration and handling code
-  #if 1
+  #ifndef NO_ACK_PL
     #define ACK_PL         // allow PRX to send payload with ACK in DYNPL feature
+    #ifndef NO_ACK_POOL
+      #define ACK_POOL     // ACK payloads queued per pipe, TX FIFO kept loaded (rf24_ackpl.h)
+      #warning "ACK_POOL is ENABLED"
+    #endif
   #endif
  #endif
 #endif
@@ -110,6 +187,7 @@
 #define FLUSH_RX 	    0xE2 // Define flush RX register command
 #define REUSE_TX_PL     0xE3 // Define reuse TX payload register command
 #define NOP 		    0xFF // Define No Operation, might be used to read status register
+#define RF24_PL_MAX     32   // payload width limit (WR_TX_PLOAD, R_RX_PAYLOAD)
 
 //***************************************************
 //
@@ -161,6 +239,32 @@
 #define ST_RX_EMPTY   0x0e  // 111: RX FIFO Empty
 #define ST_TX_FULL	  0x01	// TX FIFO full.
 
+//***************************************************
+//
+// CONFIG in PTX/PRX mode: PWR_UP, CRC 2 bytes and the
+// MASK_xx bits of the IRQ sources (1: kept off the pin)
+//
+//***************************************************
+#if defined(RF24_EVT)
+ #define CONFIG_PTX   0x0e  // RX_DR, TX_DS, MAX_RT on IRQ pin, Prim:TX
+ #define CONFIG_PRX   0x0f  // RX_DR, TX_DS, MAX_RT on IRQ pin, Prim:RX
+#elif defined(RF24_IRQ)
+ #define CONFIG_PTX   0x3e  // RX_DR only on IRQ pin, Prim:TX
+ #define CONFIG_PRX   0x3f  // RX_DR only on IRQ pin, Prim:RX
+#else
+ #define CONFIG_PTX   0x7e  // IRQ pin disabled, Prim:TX
+ #define CONFIG_PRX   0x7f  // IRQ pin disabled, Prim:RX
+#endif
+
+//***************************************************
+//
+// Streaming TX payload outcome, see nRF24L01_TxStream()
+//
+//***************************************************
+#define TX_OK         0     // TX_DS: sent (and ACKed under Auto.Ack)
+#define TX_MAX_RT     1     // no ACK after SETUP_RETR retransmits
+#define TX_FLUSHED    2     // flushed from TX FIFO after MAX_RT of an earlier payload
+
 //***************************************************
 //
 // SPI(nRF24L01) FIFO Status register R/W values
@@ -172,6 +276,143 @@
 #define Ff_RX_FULL	  0x02	// RX FIFO full flag.
 #define FF_RX_EMPTY	  0x01  // RX FIFO empty flag.
 
+//***************************************************
+//
+// SPI(nRF24L01) Observe TX register values
+//
+//***************************************************
+#define OB_PLOS_CNT   0xf0  // lost packets (MAX_RT), stops at 15, reset by writing RF_CH
+#define OB_ARC_CNT    0x0f  // retransmits of the packet on air, reset when a new one starts
+
+
+/************************************************** 
+ Function: rf24_shadow_reset(); 
+ 
+ Description: 
+  Forget the cached registers (shadow) of the module,
+  call when its state is unknown (next nRF24L01_CfgLoad()
+  reads the map back)
+
+ input:
+  nrf24: nRF24L01P module - 0/1: A/B
+
+ *************************************************
+ */
+void rf24_shadow_reset(int nrf24);
+
+//***************************************************
+//
+// Radio profile: register map of a module mode kept
+// in flash (const), applied by nRF24L01_CfgLoad()
+//
+//***************************************************
+typedef struct {
+    unsigned char reg;      // register address
+    unsigned char len;      // bytes: 1 (register) or address width
+    unsigned char val;      // one byte register value (buf 0)
+    unsigned char *buf;     // address bytes, LSB first
+} rf24_cfg_t;
+
+#define RF24_CFG_REG(r, v)      { r, 1, v, 0 }      // one byte register
+#define RF24_CFG_ADDR(r, b, n)  { r, n, 0, b }      // 'n' address bytes
+#define RF24_CFG_N(t)           (sizeof(t) / sizeof((t)[0]))
+
+/************************************************** 
+ Function: nRF24L01_CfgSync(); 
+ 
+ Description: 
+  Before the soft-reset of the module: the shadow image
+  kept (module still holding it), set to the power-on
+  defaults or forgotten, checked w/ one CONFIG read
+
+ input:
+  nrf24: nRF24L01P module - 0/1: A/B
+
+ *************************************************
+ */
+void nRF24L01_CfgSync(int nrf24);
+
+/************************************************** 
+ Function: nRF24L01_CfgLoad(); 
+ 
+ Description: 
+  Apply radio profile 'cfg': every entry read back from
+  the module (one pass, warm re-init too), the ones
+  differing written and read back again (verified), the
+  shadow image updated. Put CONFIG (PWR_UP) last
+
+ input:
+  nrf24: nRF24L01P module - 0/1: A/B
+  cfg: profile table, 'n' entries
+
+ return: registers written (0: map already loaded),
+         -1: a write read back different
+
+ *************************************************
+ */
+int nRF24L01_CfgLoad(int nrf24, const rf24_cfg_t *cfg, int n);
+
+/************************************************** 
+ Function: nRF24L01_PlosReset(); 
+ 
+ Description: 
+  Restart OBSERVE_TX.PLOS_CNT by rewriting RF_CH with
+  the current channel (bypassing the shadow)
+
+ input:
+  nrf24: nRF24L01P module - 0/1: A/B
+
+ *************************************************
+ */
+void nRF24L01_PlosReset(int nrf24);
+
+#ifdef RF24_SCK_CAL
+/************************************************** 
+ Function: nRF24L01_SckCal(); 
+ 
+ Description: 
+  SCK divider calibration: TX_ADDR/ADDR_P0 written with
+  test patterns and read back at CLKDIV_MAX down to 
+  CLKDIV_MIN, the fastest passing divider locked in 
+  (one step slower if a faster one failed), the module's
+  addresses restored. SPI port only (RF24_XPORT: GPIO
+  left as is)
+
+ input:
+  nrf24: nRF24L01P module - 0/1: A/B
+
+ return: divider locked, 0: none passed (CLKDIV kept)
+
+ *************************************************
+ */
+unsigned char nRF24L01_SckCal(int nrf24);
+#endif
+
+/************************************************** 
+ Function: rf24_status(); 
+ 
+ Description: 
+  STATUS clocked back by the last transaction (no SPI access)
+
+ input:
+  nrf24: nRF24L01P module - 0/1: A/B
+
+ *************************************************
+ */
+unsigned char rf24_status(int nrf24);
+
+/************************************************** 
+ Function: SPI_Status(); 
+ 
+ Description: 
+  Read STATUS with a single byte (NOP) transaction
+
+ input:
+  nrf24: nRF24L01P module - 0/1: A/B
+
+ *************************************************
+ */
+unsigned char SPI_Status(int nrf24);
 
 /************************************************** 
  Function: SPI_Read(); 
@@ -250,11 +491,94 @@ void SetRX_Mode(int nrf24);
 //******************************************************************************************************/
 int nRF24L01_RxPacket(int nrf24, unsigned char* rx_buf, unsigned char *size);
 
+//******************************************************************************************************/
+// int nRF24L01_RxBatch(int nrf24, rf24_rx_pkt_t *pkt, int max)
+// RX all pending packets (up to 'max') until the RX FIFO is empty,
+// RX_DR cleared once per batch (RF24_EVT: call from the rx_ready handler),
+// packets beyond 'max' are held in the RX FIFO and read by the next call
+// return:
+// # of packets read into pkt[]
+//******************************************************************************************************/
+int nRF24L01_RxBatch(int nrf24, rf24_rx_pkt_t *pkt, int max);
+
+//******************************************************************************************************/
+// int nRF24L01_RxRing(int nrf24, rx_ring_t *ring)
+// RX pending packets into the ring until the RX FIFO is empty or the
+// ring is full (the rest stays in the RX FIFO for the next call,
+// RF24_EVT: raised again as rx_ready by nRF24L01_Dispatch())
+// return:
+// # of packets queued
+//******************************************************************************************************/
+int nRF24L01_RxRing(int nrf24, rx_ring_t *ring);
+
 //***********************************************************************************************************
 //void nRF24L01_TxPacket(unsigned char * tx_buf)
 //TX a packet for PTX mode
+//return 1: sent, 0: payload width not 1~32, nothing written
+//**********************************************************************************************************/
+int  nRF24L01_TxPacket(int nrf24, unsigned char* tx_addr, int addr_len, unsigned char* tx_buf, int buf_size);
+
+//***********************************************************************************************************
+// Scatter-gather TX: payload = 'nseg' segments (e.g. header + application
+// buffer) clocked out in one WR_TX_PLOAD transaction, no staging copy.
+// Total of the segment lengths is the payload width (1~32), else 0 is
+// returned w/o any SPI access; a segment w/ ptr 0 sends 'len' zeros
+// (RF24_SPI_ASYNC: clocked out by the ISR, 2+ segments staged into one)
+//**********************************************************************************************************/
+int  nRF24L01_TxPacketSG(int nrf24, unsigned char* tx_addr, int addr_len, const rf24_seg_t *seg, int nseg);
+
+#ifdef TX_STREAM
+//***********************************************************************************************************
+// Streaming PTX mode: TX FIFO topped up to 3 payloads with CE held high, 
+// completions retired on TX_DS / FIFO_STATUS and reported in TX order
+//
+// nRF24L01_TxStreamInit(): reset stream (after soft-reset), set 'done' 
+//   callback called with TX_OK/TX_MAX_RT/TX_FLUSHED for every payload
+// nRF24L01_TxStream(): queue one payload, return 1 if queued, 0 if the
+//   TX FIFO is full, 'tx_addr' differs from the queued payloads or the
+//   payload width is not 1~32
+// nRF24L01_TxStreamPoll(): retire finished payloads, return # still queued
+//   (RF24_EVT: retired by nRF24L01_TxStreamDone()/Failed(), SPI only
+//   while 3 are queued)
+// nRF24L01_TxStreamDone()/Failed(): tx_done/tx_failed event handlers
 //**********************************************************************************************************/
-void nRF24L01_TxPacket(int nrf24, unsigned char* tx_addr, int addr_len, unsigned char* tx_buf, int buf_size);
+void nRF24L01_TxStreamInit(int nrf24, void (*done)(int nrf24, int result));
+int  nRF24L01_TxStream(int nrf24, unsigned char* tx_addr, int addr_len, unsigned char* tx_buf, int buf_size);
+int  nRF24L01_TxStreamSG(int nrf24, unsigned char* tx_addr, int addr_len, const rf24_seg_t *seg, int nseg);
+int  nRF24L01_TxStreamPoll(int nrf24);
+#ifdef RF24_EVT
+void nRF24L01_TxStreamDone(int nrf24);
+void nRF24L01_TxStreamFailed(int nrf24);
+#endif
+#endif
+
+#ifdef RF24_EVT
+//***********************************************************************************************************
+// IRQ event dispatcher
+//
+// Every IRQ edge is turned into typed events from a single STATUS read,
+// the flags seen are cleared at once (IRQ line high for the next edge)
+// and the handlers (0: none) are called in the order the radio raised them:
+// - tx_done: TX_DS, payload sent (and ACKed under Auto.Ack), PRX: ACK payload sent
+// - tx_failed: MAX_RT, no ACK after SETUP_RETR retransmits, TX halted
+//   until the handler flushes or reuses the TX FIFO
+// - rx_ready: RX_DR, RX FIFO head came on 'pipe' (drain it from the handler)
+//
+// nRF24L01_EvtInit(): register the handlers of the module
+// nRF24L01_Dispatch(): call from the main loop, return the events raised
+// nRF24L01_EvtPending(): 1 if Dispatch() has work w/o a new edge (RX FIFO
+//   held back by a full ring), so the caller must not sleep
+//**********************************************************************************************************/
+typedef struct {
+    void (*tx_done)(int nrf24);
+    void (*tx_failed)(int nrf24);
+    void (*rx_ready)(int nrf24, int pipe);
+} rf24_evt_t;
+
+void nRF24L01_EvtInit(int nrf24, const rf24_evt_t *evt);
+unsigned char nRF24L01_Dispatch(int nrf24);
+int  nRF24L01_EvtPending(int nrf24);
+#endif
 
 
 #endif // _RF24_LIB_H_
@@ -0,0 +1,55 @@
+// #################################################################
+//
+// RF24 A & B control pins shared by rf24_spi.h and rf24_gpio.h
+// (CE/CSN/IRQ wired the same way whichever port clocks the data),
+// and the TX payload segment both ports gather from
+//
+// #################################################################
+#ifndef _RF24_PINS_H_
+#define _RF24_PINS_H_
+
+#include <msp430f149.h>
+
+//
+// RF24L01 Module ID defines
+//
+#define RF24L01_A   0   // connect to SPI1
+#define RF24L01_B   1   // connect to SPI0
+
+// RF24 INQ PINs (must connect on the same port group (eg. port 1)
+#define RF24_A_IRQ_PIN  BIT4  // connect to P1.4
+#define RF24_B_IRQ_PIN  BIT7  // connect to P1.7
+#define RF24_IRQ_PINS   (RF24_A_IRQ_PIN + RF24_B_IRQ_PIN) // as bits mask
+
+//###############################################################################
+//
+// First nRF24L01P (A) CE/CSN on RF socket
+//
+//###############################################################################
+#define RF24L01_A_CE_0 	  (P4OUT &= ~BIT4)  // RF24L01 pin 3
+#define RF24L01_A_CE_1 	  (P4OUT |= BIT4)
+#define RF24L01_A_CSN_0   (P4OUT &= ~BIT5)  // RF24L01 pin 4
+#define RF24L01_A_CSN_1   (P4OUT |= BIT5)
+
+//###############################################################################
+//
+// Second nRF24L01P (B) CE/CSN on generic GPIO socket
+//
+//###############################################################################
+#define RF24L01_B_CE_0 	  (P4OUT &= ~BIT6)  // RF24L01 pin 3
+#define RF24L01_B_CE_1 	  (P4OUT |= BIT6)
+#define RF24L01_B_CSN_0   (P3OUT &= ~BIT0)  // RF24L01 pin 4
+#define RF24L01_B_CSN_1   (P3OUT |= BIT0)
+
+//###############################################################################
+//
+// TX payload segment, see nRF24L01_TxPacketSG(): 'len' bytes
+// clocked out straight from 'ptr' (0: 'len' 0s)
+//
+//###############################################################################
+typedef struct {
+    unsigned char *ptr;
+    unsigned char len;
+} rf24_seg_t;
+
+#endif // _RF24_PINS_H_
@@ -0,0 +1,134 @@
+// #################################################################
+//
+// RF24 Tiered Fault Recovery Routines
+//
+// Main loop context only (keep-alive timeouts of the application).
+//
+// #################################################################
+#include <string.h>
+#include "../device_lib/rf24_recov.h"
+#include "../device_lib/rf24_stats.h"
+
+#ifdef RF24_RECOV
+
+rf24_recov_t rf24_recov[2];     // RF24 A/B
+
+/**************************************************
+Function: rf24_recov_init();
+
+Description:
+  Module 'nrf24' runs in mode 'config' (CONFIG_PTX or
+  CONFIG_PRX, CONFIG read back w/ anything else: lost),
+  'reinit' is its full init for the last tier
+
+ **************************************************
+ */
+void rf24_recov_init(int nrf24, unsigned char config, void (*reinit)(void))
+{
+    rf24_recov_t *rc = &rf24_recov[nrf24];
+
+    memset(rc, 0, sizeof(rf24_recov_t));
+    rc->config = config;
+    rc->reinit = reinit;
+}
+
+//=============================================
+// cheapest tier for the registers read, 'fault'
+// 0: nothing wrong seen (PRX w/o traffic)
+//=============================================
+static int recov_diagnose(rf24_recov_t *rc, int *fault)
+{
+    *fault = 1;
+    if (rc->cfg_read != rc->config) {
+        return RCV_INIT;                    // brown-out or corrupted, map gone
+    }
+    if (rc->config & CFG_PRIM_RX) {
+        if (rc->status & (ST_RX_DR | ST_TX_DS | ST_MAX_RT)) return RCV_CLEAR;  // edge missed
+        if (rc->fifo & Ff_RX_FULL) return RCV_FLUSH;    // RX FIFO stuck full
+        *fault = 0;
+        return RCV_CE;                      // silent: RX left w/o a CE edge ?
+    }
+    if (rc->status & (ST_TX_DS | ST_MAX_RT)) return RCV_FLUSH;  // edge missed, PTX restarts empty
+    if (rc->fifo & FF_TX_EMPTY) return RCV_FLUSH;
+    if (rc->observe & OB_ARC_CNT) return RCV_FLUSH; // retransmitting, radio alive
+    return RCV_CE;                          // payload held, nothing on air
+}
+
+/**************************************************
+Function: rf24_recover();
+
+Description:
+  Keep-alive timeout of module 'nrf24': STATUS, CONFIG,
+  FIFO_STATUS and OBSERVE_TX (PTX) read, the cheapest
+  tier fitting applied, at least the one after the last
+  recovery if traffic did not come back since (RECOV_OK).
+  Tiers below the one applied are done as well:
+
+  RCV_FLUSH: PTX TX FIFO (STATS_FLUSH), PRX RX FIFO if full
+  RCV_CLEAR: TX_DS/MAX_RT cleared; PRX RX_DR left for its
+             RX drain (RF24_IRQ: edge marked pending again)
+  RCV_PWR:   PWR_UP off/on, CE low, Tpd2stby waited out
+  RCV_CE:    CE low then high, Standby left again
+  RCV_INIT:  shadow forgotten, 'reinit' (map read back)
+
+  PTX: no payload left in the TX FIFO, TX stream (if any)
+  to be restarted by the caller
+
+return: tier applied
+
+ **************************************************
+ */
+int rf24_recover(int nrf24)
+{
+    rf24_recov_t *rc = &rf24_recov[nrf24];
+    unsigned long t0 = get_stamp(), t1;
+    int tier, fault;
+
+    rc->cfg_read = SPI_Read(nrf24, READ_REG + CONFIG);
+    rc->fifo = SPI_Read(nrf24, READ_REG + FIFO_STATUS);
+    rc->observe = (rc->config & CFG_PRIM_RX) ? 0 : SPI_Read(nrf24, READ_REG + OBSERVE_TX);
+    rc->status = rf24_status(nrf24);
+
+    tier = recov_diagnose(rc, &fault);
+    if (fault) {
+        if (tier < rc->level) tier = rc->level;     // same fix failed before
+        rc->level = (tier < RCV_INIT) ? tier + 1 : RCV_INIT;
+        rc->probe = (tier < RCV_INIT);
+    }
+
+    if (tier == RCV_INIT) {
+        rf24_shadow_reset(nrf24);
+        rc->reinit();
+    } else {
+        if (tier >= RCV_FLUSH) {
+            if (!(rc->config & CFG_PRIM_RX)) {
+                SPI_Write_Reg(nrf24, FLUSH_TX);
+                STATS_FLUSH(nrf24);
+            } else if (rc->fifo & Ff_RX_FULL) {
+                SPI_Write_Reg(nrf24, FLUSH_RX);
+            }
+        }
+        SPI_RW_Reg(nrf24, WRITE_REG + STATUS, ST_TX_DS | ST_MAX_RT);
+#ifdef RF24_IRQ
+        if (rc->status & ST_RX_DR) {
+            rf24_irq_recheck(nrf24);    // RX FIFO drained by the PRX task, RX_DR cleared there
+        }
+#endif
+        if (tier >= RCV_CE) {
+            RF24_CE_0(nrf24);
+            if (tier >= RCV_PWR) {
+                SPI_RW_Reg(nrf24, WRITE_REG + CONFIG, rc->config & ~CFG_PWR_UP);
+                SPI_RW_Reg(nrf24, WRITE_REG + CONFIG, rc->config);
+                t1 = get_stamp();
+                while (stamp_us(get_stamp() - t1) < RCV_PD2STBY_US);   // Power Down -> Standby-I
+            }
+            RF24_CE_1(nrf24);
+        }
+    }
+
+    rc->runs[tier]++;
+    rc->cycles[tier] += get_stamp() - t0;
+    return tier;
+}
+
+#endif // RF24_RECOV
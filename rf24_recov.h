@@ -0,0 +1,85 @@
+// #################################################################
+//
+// RF24 Tiered Fault Recovery Headfile (RF24_RECOV)
+//
+// Called on a TX/RX keep-alive timeout instead of a full re-init:
+// STATUS, FIFO_STATUS, OBSERVE_TX (PTX) and CONFIG are read, the
+// cheapest tier that fits is applied. A tier does the work of the
+// ones below it too. The same fault back before traffic resumed
+// (RECOV_OK()) takes the next tier up, the full reconfigure
+// last. A PRX merely not hearing anything gets a CE pulse, never
+// escalated: an idle link looks the same.
+//
+// #################################################################
+#ifndef _RF24_RECOV_H_
+#define _RF24_RECOV_H_
+
+#include "../device_lib/rf24_lib.h"
+#include "../device_lib/timer_lib.h"
+
+//***************************************************
+//
+// Recovery tiers, cheapest first
+//
+//***************************************************
+#define RCV_CLEAR   0   // flags cleared, PRX RX_DR serviced (IRQ edge missed)
+#define RCV_FLUSH   1   // + PTX: TX FIFO flushed, PRX: RX FIFO if full
+#define RCV_CE      2   // + CE pulsed: Standby left again
+#define RCV_PWR     3   // + PWR_UP cycled: crystal/PLL restarted
+#define RCV_INIT    4   // full reconfigure (reinit), map read back
+#define RCV_TIERS   5
+
+#define RCV_PROBE_MS  20    // keep-alive after a recovery, until traffic resumed
+#define RCV_PD2STBY_US 1500 // Tpd2stby: PWR_UP to Standby-I (crystal start-up)
+
+#define CFG_PWR_UP  0x02    // CONFIG PWR_UP bit
+#define CFG_PRIM_RX 0x01    // CONFIG PRIM_RX bit
+
+//***************************************************
+//
+// Recovery state & statistics of one module
+//
+//***************************************************
+typedef struct {
+    unsigned char config;           // CONFIG of the mode (CONFIG_PTX/PRX)
+    void (*reinit)(void);           // full reconfigure, RCV_INIT
+    unsigned char level;            // lowest tier of the next recovery
+    unsigned char probe;            // 1: fault fixed, traffic not seen since
+    // registers at the last diagnosis
+    unsigned char status;
+    unsigned char fifo;
+    unsigned char observe;
+    unsigned char cfg_read;
+    // per tier: times applied, SMCLK counts spent (diagnosis included)
+    unsigned long runs[RCV_TIERS];
+    unsigned long cycles[RCV_TIERS];
+} rf24_recov_t;
+
+extern rf24_recov_t rf24_recov[2];      // RF24 A/B
+
+// module in mode 'config' (CONFIG_PTX/CONFIG_PRX), 'reinit': its
+// full init (soft-reset & profile, PRX: RX mode entered); counters cleared
+void rf24_recov_init(int nrf24, unsigned char config, void (*reinit)(void));
+
+// keep-alive timeout: diagnose & fix, returns the tier applied.
+// PTX: TX FIFO empty afterwards (payloads queued are gone)
+int rf24_recover(int nrf24);
+
+//***************************************************
+//
+// Application hooks, w/o RF24_RECOV: no tier state
+//
+//***************************************************
+#ifdef RF24_RECOV
+ // traffic flowing (TX_DS / packet received): next recovery from the
+ // cheapest tier again
+ #define RECOV_OK(n)         (rf24_recov[n].level = rf24_recov[n].probe = 0)
+ // keep-alive deadline in ticks: 't', RCV_PROBE_MS after a fault
+ // fixed until traffic confirms it
+ #define RECOV_TMOUT(n, t)   (rf24_recov[n].probe ? RCV_PROBE_MS / TM_TIME_MS : (t))
+#else
+ #define RECOV_OK(n)
+ #define RECOV_TMOUT(n, t)   (t)
+#endif
+
+#endif // _RF24_RECOV_H_
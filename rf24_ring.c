@@ -0,0 +1,76 @@
+// #################################################################
+//
+// RF24 RX Packet Ring Buffer Routines
+//
+// head/tail are free running counters, slot index = counter & mask,
+// count = head - tail (8-bit wrap), so all RX_RING_SIZE slots are
+// usable. A slot is written before 'head' moves past it and read
+// before 'tail' does, the function call keeps the compiler from
+// reordering the two.
+//
+// #################################################################
+#include "../device_lib/rf24_ring.h"
+
+//=============================================
+// empty the ring and clear the counters
+//=============================================
+void rx_ring_init(rx_ring_t *r)
+{
+    r->head = 0;
+    r->tail = 0;
+    r->hwm  = 0;
+    r->ovf  = 0;
+}
+
+//=============================================
+// # of packets queued
+//=============================================
+unsigned char rx_ring_count(rx_ring_t *r)
+{
+    return (unsigned char)(r->head - r->tail);
+}
+
+//=============================================
+// producer: free slot to fill, 0 if full
+//=============================================
+rf24_rx_pkt_t *rx_ring_slot(rx_ring_t *r)
+{
+    unsigned char head = r->head;
+    
+    if ((unsigned char)(head - r->tail) >= RX_RING_SIZE) {
+        if (++r->ovf == 0) r->ovf--;    // saturated
+        return 0;
+    }
+    return &r->slot[head & RX_RING_MASK];
+}
+
+//=============================================
+// producer: queue the slot filled
+//=============================================
+void rx_ring_put(rx_ring_t *r)
+{
+    unsigned char used;
+    
+    r->head++;
+    used = (unsigned char)(r->head - r->tail);
+    if (used > r->hwm) r->hwm = used;
+}
+
+//=============================================
+// consumer: oldest packet, 0 if empty
+//=============================================
+rf24_rx_pkt_t *rx_ring_peek(rx_ring_t *r)
+{
+    unsigned char tail = r->tail;
+    
+    if (r->head == tail) return 0;
+    return &r->slot[tail & RX_RING_MASK];
+}
+
+//=============================================
+// consumer: release the oldest packet
+//=============================================
+void rx_ring_pop(rx_ring_t *r)
+{
+    if (r->head != r->tail) r->tail++;
+}
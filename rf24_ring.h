@@ -0,0 +1,69 @@
+// #################################################################
+//
+// RF24 RX Packet Ring Buffer Headfile
+//
+// Single-producer/single-consumer ring of RX packet slots between
+// the receive path (RX FIFO drain, main loop or ISR) and the
+// application. The producer only moves 'head', the consumer only
+// moves 'tail', both byte wide (atomic on MSP430), so no interrupt
+// lock is needed as long as each side stays in one context.
+//
+// #################################################################
+#ifndef _RF24_RING_H_
+#define _RF24_RING_H_
+
+#include <msp430f149.h>
+
+#ifndef RX_RING_SIZE
+ #define RX_RING_SIZE   8       // # of packet slots, power of 2 (<= 128)
+#endif
+#define RX_RING_MASK    (RX_RING_SIZE - 1)
+
+#if (RX_RING_SIZE & RX_RING_MASK) || (RX_RING_SIZE > 128)
+ #error "RX_RING_SIZE must be a power of 2 up to 128"
+#endif
+
+//***************************************************
+//
+// RX packet record, see nRF24L01_RxBatch()
+//
+//***************************************************
+typedef struct {
+    unsigned char pipe;         // 0~5
+    unsigned char len;          // payload width
+    unsigned long ts;           // get_stamp() of arrival (IRQ edge) or RX FIFO read
+    unsigned char data[32];
+} rf24_rx_pkt_t;
+
+//***************************************************
+//
+// RX packet ring
+//
+//***************************************************
+typedef struct {
+    volatile unsigned char head;    // next slot to fill (producer)
+    volatile unsigned char tail;    // next slot to pop (consumer)
+    unsigned char hwm;              // high-water mark, max # of slots used
+    unsigned int  ovf;              // # of times a packet found it full (left in RX FIFO)
+    rf24_rx_pkt_t slot[RX_RING_SIZE];
+} rx_ring_t;
+
+// empty the ring and clear the counters (no producer/consumer running)
+void rx_ring_init(rx_ring_t *r);
+
+// # of packets queued
+unsigned char rx_ring_count(rx_ring_t *r);
+
+// producer: free slot to fill, 0 if full (counted in 'ovf')
+rf24_rx_pkt_t *rx_ring_slot(rx_ring_t *r);
+
+// producer: queue the slot filled after rx_ring_slot()
+void rx_ring_put(rx_ring_t *r);
+
+// consumer: oldest packet, 0 if empty (stays queued until rx_ring_pop())
+rf24_rx_pkt_t *rx_ring_peek(rx_ring_t *r);
+
+// consumer: release the packet returned by rx_ring_peek()
+void rx_ring_pop(rx_ring_t *r);
+
+#endif // _RF24_RING_H_
@@ -13,54 +13,227 @@
 
 #include <msp430f149.h>
 #include "../device_lib/rf24_spi.h"
+#include "../device_lib/timer_lib.h"
+#include "../device_lib/pb_lib.h"
+#include "../device_lib/sched_lib.h"
 
-unsigned char rf24_ifg;  // RF24 interrupt flags on RF24_IRQ_PINS (1:on)
+volatile unsigned char rf24_ifg;  // RF24 interrupt flags on RF24_IRQ_PINS (1:on), set by RF24_isr only
+unsigned long rf24_irq_ts[2];  // get_stamp() of the last IRQ edge of RF24 A/B
+unsigned char rf24_irq_rdy[2]; // sched_lib ready bits of RF24 A/B on an IRQ edge
+
+unsigned char spi_div[2] = { CLKDIV, CLKDIV };  // UxBR0 of RF24 A (SPI1) / B (SPI0)
+
+#ifdef RF24_SPI_ASYNC
+spi_xfer_t * volatile spi_async[2];  // transaction in flight on RF24 A/B
+#endif
 
 // @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
 //
-//      << SPI0 port Write & Read >>
+//      << SPI0 port burst Write & Read >>
 //
 // @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
-unsigned char spi0_rw(unsigned char out)
-{ 
-  // readout any pre-rx data first
-  TXBUF0 = out;
-  while (!(IFG1 & URXIFG0));  // RXSREG stored into RXBUF ?
-  return RXBUF0;
+unsigned char spi0_xfer(unsigned char cmd, unsigned char *tx, unsigned char *rx, unsigned char len)
+{
+  unsigned char status;
+
+  // command byte, STATUS shifted back
+  TXBUF0 = cmd;
+  while (!(IFG1 & URXIFG0));
+  status = RXBUF0;
+
+  if (rx) {
+    // read: RXBUF must be taken before the next byte lands (OE),
+    // so keep one byte in flight
+    while (len--) {
+      TXBUF0 = tx ? *tx++ : 0;
+      while (!(IFG1 & URXIFG0));
+      *rx++ = RXBUF0;
+    }
+  } else if (len) {
+    // write: refill TXBUF as soon as it moved into the shifter
+    while (len--) {
+      while (!(IFG1 & UTXIFG0));
+      TXBUF0 = tx ? *tx++ : 0;
+    }
+    while (!(U0TCTL & TXEPT));  // last byte shifted out ?
+    (void)RXBUF0;              // flush RXBUF, clear URXIFG0
+  }
+  return status;
 }
 
 // @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
 //
-//      << SPI1 port Write & Read >>
+//      << SPI1 port burst Write & Read >>
 //
 // @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
-unsigned char spi1_rw(unsigned char out)
-{ 
-  // send out byte to TX
-  TXBUF1 = out;
-  while (!(IFG2 & URXIFG1));  // RXSREG stored into RXBUF ?  
-  return RXBUF1;
+unsigned char spi1_xfer(unsigned char cmd, unsigned char *tx, unsigned char *rx, unsigned char len)
+{
+  unsigned char status;
+
+  // command byte, STATUS shifted back
+  TXBUF1 = cmd;
+  while (!(IFG2 & URXIFG1));
+  status = RXBUF1;
+
+  if (rx) {
+    // read: RXBUF must be taken before the next byte lands (OE),
+    // so keep one byte in flight
+    while (len--) {
+      TXBUF1 = tx ? *tx++ : 0;
+      while (!(IFG2 & URXIFG1));
+      *rx++ = RXBUF1;
+    }
+  } else if (len) {
+    // write: refill TXBUF as soon as it moved into the shifter
+    while (len--) {
+      while (!(IFG2 & UTXIFG1));
+      TXBUF1 = tx ? *tx++ : 0;
+    }
+    while (!(U1TCTL & TXEPT));  // last byte shifted out ?
+    (void)RXBUF1;              // flush RXBUF, clear URXIFG1
+  }
+  return status;
 }
 
-/************************************************** 
-Function: spi_rw(); 
- 
-Description: 
-  Writes one byte to nRF24L01, and return the byte read 
-  from nRF24L01 during write, according to SPI protocol
+// @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//
+//      << SPI0/SPI1 port gathered Write burst >>
+//
+// Write path of spiN_xfer() walking 'nseg' segments: TXBUF kept
+// refilled across segment boundaries, one drain at the end
+//
+// @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+unsigned char spi0_xfer_sg(unsigned char cmd, const rf24_seg_t *seg, int nseg)
+{
+  unsigned char status, len, *tx;
 
-input:
-  nrf24: nRF24L01P module - 0/1: A/B (SPI1/SPI0)
+  TXBUF0 = cmd;
+  while (!(IFG1 & URXIFG0));
+  status = RXBUF0;
 
-Notes: the SPI device's CSN level will be handled by the caller
+  for (; nseg > 0; nseg--, seg++) {
+    for (tx = seg->ptr, len = seg->len; len; len--) {
+      while (!(IFG1 & UTXIFG0));
+      TXBUF0 = tx ? *tx++ : 0;
+    }
+  }
+  while (!(U0TCTL & TXEPT));  // last byte shifted out ?
+  (void)RXBUF0;              // flush RXBUF, clear URXIFG0
+  return status;
+}
 
- **************************************************
- */
-unsigned char spi_rw(int nrf24, unsigned char data)
+unsigned char spi1_xfer_sg(unsigned char cmd, const rf24_seg_t *seg, int nseg)
 {
-	return (nrf24 ? spi0_rw(data) : spi1_rw(data));
+  unsigned char status, len, *tx;
+
+  TXBUF1 = cmd;
+  while (!(IFG2 & URXIFG1));
+  status = RXBUF1;
+
+  for (; nseg > 0; nseg--, seg++) {
+    for (tx = seg->ptr, len = seg->len; len; len--) {
+      while (!(IFG2 & UTXIFG1));
+      TXBUF1 = tx ? *tx++ : 0;
+    }
+  }
+  while (!(U1TCTL & TXEPT));  // last byte shifted out ?
+  (void)RXBUF1;              // flush RXBUF, clear URXIFG1
+  return status;
 }
 
+#ifdef RF24_SPI_ASYNC
+// @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//
+//      << Asynchronous SPI transaction >>
+//
+// One byte per USART RX interrupt: RXBUF stored, next TXBUF loaded,
+// CSN raised after the last byte. Only one transaction in flight per
+// USART; the synchronous routines must call spi_xfer_wait() first.
+//
+// @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+void spi_xfer_wait(int nrf24)
+{
+  while (spi_async[nrf24]) {  // cleared by the RX ISR
+    SIM_CYCLES(6);            // RAM poll, let the USART run
+  }
+}
+
+void spi_xfer_async(int nrf24, spi_xfer_t *x)
+{
+  spi_xfer_wait(nrf24);
+
+  x->idx = 0;
+  x->busy = 1;
+  spi_async[nrf24] = x;
+
+  if (nrf24) {
+    RF24L01_B_CSN_0;
+    IE1 |= URXIE0;            // RX byte -> SPI0_rx()
+    TXBUF0 = x->cmd;
+  } else {
+    RF24L01_A_CSN_0;
+    IE2 |= URXIE1;            // RX byte -> SPI1_rx()
+    TXBUF1 = x->cmd;
+  }
+}
+
+// store RX byte 'in', return 1 with next TX byte in *out, 0 if done
+static int spi_async_step(spi_xfer_t *x, unsigned char in, unsigned char *out)
+{
+  if (x->idx == 0) {
+    x->status = in;
+  } else if (x->rx) {
+    x->rx[x->idx - 1] = in;
+  }
+  
+  if (x->idx++ < x->len) {
+    *out = x->tx ? x->tx[x->idx - 1] : 0;
+    return 1;
+  }
+  return 0;
+}
+
+// transaction complete, CSN already high
+static void spi_async_end(int nrf24)
+{
+  spi_xfer_t *x = spi_async[nrf24];
+
+  spi_async[nrf24] = 0;
+  x->busy = 0;
+  if (x->done) x->done(nrf24);
+}
+
+// USART0 (RF24 B) RX interrupt
+#pragma vector=USART0RX_VECTOR
+__interrupt void SPI0_rx(void)
+{
+  unsigned char out;
+
+  if (spi_async_step(spi_async[RF24L01_B], RXBUF0, &out)) {
+    TXBUF0 = out;
+  } else {
+    IE1 &= ~URXIE0;           // back to polled spi0_xfer()
+    RF24L01_B_CSN_1;
+    spi_async_end(RF24L01_B);
+  }
+}
+
+// USART1 (RF24 A) RX interrupt
+#pragma vector=USART1RX_VECTOR
+__interrupt void SPI1_rx(void)
+{
+  unsigned char out;
+
+  if (spi_async_step(spi_async[RF24L01_A], RXBUF1, &out)) {
+    TXBUF1 = out;
+  } else {
+    IE2 &= ~URXIE1;           // back to polled spi1_xfer()
+    RF24L01_A_CSN_1;
+    spi_async_end(RF24L01_A);
+  }
+}
+#endif // RF24_SPI_ASYNC
+
 // @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
 //
 //      << initialize SPI1 >>
@@ -85,7 +258,7 @@ void init_spi_A_master(void) {
     
   U1CTL = CHAR + SYNC + MM + SWRST;         // 8-bit, SPI, master
   U1TCTL = CKPH + SSEL1 + STC;              // Phase=1, polarity=0, SMCLK, 3-wire
-  U1BR0 = CLKDIV;                           // SPICLK = SMCLK/2 (div=1 not working)
+  U1BR0 = spi_div[RF24L01_A];               // SPICLK = SMCLK/2 (UxBR < 2 not allowed)
   U1BR1 = 0x00;
   U1MCTL = 0x00;
   ME2 |= USPIE1;                            // Module enable
@@ -118,13 +291,43 @@ void init_spi_B_master(void) {
   
   U0CTL = CHAR + SYNC + MM + SWRST;         // 8-bit, SPI, master
   U0TCTL = CKPH + SSEL1 + STC;              // Phase=1, polarity=0, SMCLK, 3-wire
-  U0BR0 = CLKDIV;                           // SPICLK = SMCLK/2 (4 MHz ?)
+  U0BR0 = spi_div[RF24L01_B];               // SPICLK = SMCLK/2 (4 MHz ?)
   U0BR1 = 0x00;
   U0MCTL = 0x00;
   ME1 |= USPIE0;                            // Module enable
   U0CTL &= ~SWRST;                          // SPI enable 
 }
 
+// @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+//
+//      << SCK divider of RF24 A/B >>
+//
+// UxBR0 written w/ the USART held in reset (SWRST), no
+// transaction of the module may be in flight.
+// 'div' below CLKDIV_MIN taken as CLKDIV_MIN
+//
+// @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+void spi_set_div(int nrf24, unsigned char div)
+{
+  if (div < CLKDIV_MIN) div = CLKDIV_MIN;
+  spi_div[nrf24] = div;
+
+  if (nrf24) {
+    U0CTL |= SWRST;
+    U0BR0 = div;
+    U0CTL &= ~SWRST;
+  } else {
+    U1CTL |= SWRST;
+    U1BR0 = div;
+    U1CTL &= ~SWRST;
+  }
+}
+
+unsigned char spi_get_div(int nrf24)
+{
+  return spi_div[nrf24];
+}
+
 // RF24 A&B IRQ initization routine
 //
 // ============ MSP430 Port IO setup =============
@@ -143,38 +346,133 @@ void init_rf24_irq(void)
 }
 
 // Port 1 interrupt service routine for SPI0 & SPI1
+//
+// Only the RF24_IRQ_PINS flags are owned (and cleared) here. Any other
+// P1 edge (keys) stays latched in P1IFG, with its P1IE masked, and is
+// handed to pb_ifg until pb_lib takes it and re-arms (see pb_get()).
 #pragma vector=PORT1_VECTOR
 __interrupt void RF24_isr(void)
 {    
-   rf24_ifg |= (P1IFG & RF24_IRQ_PINS); // set raised IFG bits 
-   P1IFG    = 0x00;                     // clear all IFG bits 
+   unsigned char ifg = P1IFG & RF24_IRQ_PINS;
+   unsigned char other = P1IFG & P1IE & ~RF24_IRQ_PINS;
+   unsigned long ts = get_stamp();      // P1.4/P1.7 are no TA capture inputs
+   
+   P1IFG &= ~ifg;                       // clear the IFG bits taken only
+   P1IE  &= ~other;                     // foreign edges left to their owner
+   pb_ifg |= other;                     // key edges to pb_get()
+   rf24_ifg |= ifg;                     // set raised IFG bits 
+   
+   if (ifg & RF24_A_IRQ_PIN) {
+       rf24_irq_ts[RF24L01_A] = ts;
+       SCHED_READY(rf24_irq_rdy[RF24L01_A]);
+   }
+   if (ifg & RF24_B_IRQ_PIN) {
+       rf24_irq_ts[RF24L01_B] = ts;
+       SCHED_READY(rf24_irq_rdy[RF24L01_B]);
+   }
+   if (other) SCHED_READY(pb_rdy);
+   
+   _BIC_SR_IRQ(LPM0_bits);              // wake main loop (tm_idle()) on any P1 edge
 
 #ifdef DBG_RF24_ISR
    P2OUT &= ~rf24_ifg;                // XXX:FRED Debug
 #endif
 }
 
-/* check RF24 IRQ Status
+/* any RF24 IRQ not yet taken by is_rf24_irq() ?
+ *
+ * return: 1/0: true/flase
+ * 
+ */ 
+int rf24_irq_pending(void) {
+    return (rf24_ifg & RF24_IRQ_PINS) ? 1 : 0;
+}
+
+/* check RF24 IRQ Status, taking (clearing) the pending bit
  *
  * nrf24: 0/1:RF24_A/RF24_B
  * return: 1/0: true/flase
  * 
+ * Callable w/ GIE on or off, the interrupt state is restored
  */ 
 int is_rf24_irq(int nrf24) {
-    // RF24 IRQ Raised ?
-    if (!(rf24_ifg & 
-          (nrf24 ? RF24_B_IRQ_PIN : RF24_A_IRQ_PIN))) {
+    unsigned char pin = nrf24 ? RF24_B_IRQ_PIN : RF24_A_IRQ_PIN;
+    unsigned int sr;
+    
+    // RF24 IRQ Raised ? (only RF24_isr sets it, a clear bit needs no lock)
+    if (!(rf24_ifg & pin)) {
        // no IRQ 
        return 0;
     }
         
-    _BIC_SR(GIE);     /* Interrupts disabled */
+    sr = __get_SR_register();
+    _BIC_SR(GIE);
 
-    // clear rf24_ifg IRQ bit
-    rf24_ifg &= ~(nrf24 ? RF24_B_IRQ_PIN : RF24_A_IRQ_PIN);
+    // clear rf24_ifg IRQ bit (read-modify-write vs. RF24_isr of the other pin)
+    rf24_ifg &= ~pin;
          
-    _BIS_SR(GIE);     /* Interrupts enabled */        
+    _BIS_SR(sr & GIE);
     
     return 1;
 }  
+
+/* re-check the IRQ line after STATUS flags were cleared
+ *
+ * nrf24: 0/1:RF24_A/RF24_B
+ * 
+ * The IRQ line is level-low: a flag raised before the clear (or one
+ * not cleared) keeps it low, so no hi/lo edge comes for it. Mark it
+ * pending as if the edge had been seen.
+ */ 
+void rf24_irq_recheck(int nrf24) {
+    unsigned char pin = nrf24 ? RF24_B_IRQ_PIN : RF24_A_IRQ_PIN;
+    unsigned int sr;
+    
+    if (P1IN & pin) return;     // line high: next flag raises an edge
+    
+    sr = __get_SR_register();
+    _BIC_SR(GIE);
+    rf24_ifg |= pin;
+    _BIS_SR(sr & GIE);
+    sched_ready(rf24_irq_rdy[nrf24]);
+}  
+
+/* RF24 IRQ line level
+ *
+ * nrf24: 0/1:RF24_A/RF24_B
+ * return: 1 while the module holds its IRQ line low (a flag still set),
+ *         no new edge comes until all of them are cleared
+ * 
+ */ 
+int rf24_irq_line(int nrf24) {
+    return (P1IN & (nrf24 ? RF24_B_IRQ_PIN : RF24_A_IRQ_PIN)) ? 0 : 1;
+}
+
+/* IRQ edge time stamp
+ *
+ * nrf24: 0/1:RF24_A/RF24_B
+ * return: get_stamp() taken by RF24_isr on the last edge
+ * 
+ */ 
+unsigned long rf24_irq_stamp(int nrf24) {
+    unsigned long ts;
+    unsigned int sr;
+    
+    sr = __get_SR_register();
+    _BIC_SR(GIE);
+    ts = rf24_irq_ts[nrf24];
+    _BIS_SR(sr & GIE);
+
+    return ts;
+}
+
+/* tasks readied by the IRQ edges
+ *
+ * nrf24: 0/1:RF24_A/RF24_B
+ * rdy: SCHED_BIT()s of the tasks handling the module, 0: none
+ *
+ */
+void rf24_irq_sched(int nrf24, unsigned char rdy) {
+    rf24_irq_rdy[nrf24] = rdy;      // one byte write, no IRQ lock
+}
 #endif // _RF24_SPI_
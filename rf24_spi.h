@@ -8,48 +8,66 @@
 
 #include <msp430f149.h>
 
-//
-// RF24L01 Module ID defines
-//
-#define RF24L01_A   0   // connect to SPI1
-#define RF24L01_B   1   // connect to SPI0
-
-// RF24 INQ PINs (must connect on the same port group (eg. port 1)
-#define RF24_A_IRQ_PIN  BIT4  // connect to P1.4
-#define RF24_B_IRQ_PIN  BIT7  // connect to P1.7
-#define RF24_IRQ_PINS   (RF24_A_IRQ_PIN + RF24_B_IRQ_PIN) // as bits mask
- 
-//###############################################################################
-// 
-// First nRF24L01P (A) GPIO configuration for SPI1 interface on RF socket
-//
-//###############################################################################
-#define RF24L01_A_CE_0 	  (P4OUT &= ~BIT4)  // RF24L01 pin 3
-#define RF24L01_A_CE_1 	  (P4OUT |= BIT4)
-#define RF24L01_A_CSN_0   (P4OUT &= ~BIT5)  // RF24L01 pin 4
-#define RF24L01_A_CSN_1   (P4OUT |= BIT5)
-
-//###############################################################################
-// 
-// Second nRF24L01P (B) GPIO configuration for SPI0 interface on generic GPIO socket
-//
-//###############################################################################
-#define RF24L01_B_CE_0 	  (P4OUT &= ~BIT6)  // RF24L01 pin 3
-#define RF24L01_B_CE_1 	  (P4OUT |= BIT6)
-#define RF24L01_B_CSN_0   (P3OUT &= ~BIT0)  // RF24L01 pin 4
-#define RF24L01_B_CSN_1   (P3OUT |= BIT0)
+#include "../device_lib/rf24_pins.h"  // module IDs, CE/CSN, IRQ pins
 
 // initialize SPI
 void init_spi_A_master(void);  // SPI1
 void init_spi_B_master(void);  // SPI0
 
-// SPI byte write & read
-unsigned char spi_rw(int nrf24, unsigned char out);
+// SCK divider (UxBR0) of RF24 A/B, kept over init_spi_x_master()
+void spi_set_div(int nrf24, unsigned char div);
+unsigned char spi_get_div(int nrf24);
+
+// SPI burst: command byte + len data bytes, returns STATUS
+unsigned char spi0_xfer(unsigned char cmd, unsigned char *tx, unsigned char *rx, unsigned char len);  // RF24 B
+unsigned char spi1_xfer(unsigned char cmd, unsigned char *tx, unsigned char *rx, unsigned char len);  // RF24 A
+
+// SPI write burst: command byte + bytes gathered from 'nseg' segments, returns STATUS
+unsigned char spi0_xfer_sg(unsigned char cmd, const rf24_seg_t *seg, int nseg);  // RF24 B
+unsigned char spi1_xfer_sg(unsigned char cmd, const rf24_seg_t *seg, int nseg);  // RF24 A
+
+#ifdef RF24_SPI_ASYNC
+// Asynchronous SPI transaction descriptor, owned by the caller.
+// CSN is lowered by spi_xfer_async() and raised by the USART RX
+// ISR after the last byte, then 'done' (if any) is called from
+// the ISR. Buffers must stay untouched until 'busy' drops.
+typedef struct {
+  unsigned char cmd;            // command byte
+  unsigned char *tx;            // data out (0: send 0s)
+  unsigned char *rx;            // data in (0: discard)
+  unsigned char len;            // data bytes after 'cmd'
+  void (*done)(int nrf24);      // completion callback, ISR context
+  unsigned char status;         // STATUS read during 'cmd'
+  unsigned char idx;            // bytes received so far
+  volatile unsigned char busy;  // 1: in flight
+} spi_xfer_t;
+
+// start a transaction (waits for the one in flight on this USART)
+void spi_xfer_async(int nrf24, spi_xfer_t *x);
+
+// wait until no transaction in flight on this USART
+void spi_xfer_wait(int nrf24);
+#endif
 
 // RF24 A&B IRQ initization routine
 void init_rf24_irq(void);
         
-// check RF24 IRQ Status
+// check RF24 IRQ Status (takes the pending bit)
 int is_rf24_irq(int nrf24);
 
+// STATUS flags cleared: IRQ line still low -> pending again
+void rf24_irq_recheck(int nrf24);
+
+// any RF24 IRQ not yet checked by is_rf24_irq()
+int rf24_irq_pending(void);
+
+// IRQ line held low by the module (level, not edge)
+int rf24_irq_line(int nrf24);
+
+// get_stamp() of the last IRQ edge
+unsigned long rf24_irq_stamp(int nrf24);
+
+// sched_lib ready bits set on an IRQ edge of the module (RF24_isr)
+void rf24_irq_sched(int nrf24, unsigned char rdy);
+
 #endif // _RF24_SPI_H_
\ No newline at end of file
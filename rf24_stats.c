@@ -0,0 +1,184 @@
+// #################################################################
+//
+// RF24 Per Pipe Statistics Routines
+//
+// Counters only change in main loop context (application hooks),
+// readers in the same context need no interrupt lock.
+//
+// #################################################################
+#include <string.h>
+#include "../device_lib/rf24_stats.h"
+
+#ifdef RF24_STATS
+
+rf24_stats_t rf24_stats[2];     // RF24 A/B
+
+//=============================================
+// histogram bin of latency dt (log2 scale)
+//=============================================
+static unsigned char lat_bin(unsigned long dt)
+{
+    unsigned char bin = 0;
+    
+    while (dt && bin < RF24_LAT_BINS - 1) {
+        dt >>= 1;
+        bin++;
+    }
+    return bin;
+}
+
+//=============================================
+// harvest OBSERVE_TX into the pipe counters
+//=============================================
+static void stats_observe(int nrf24, rf24_pipe_stats_t *ps)
+{
+    rf24_stats_t *st = &rf24_stats[nrf24];
+    unsigned char ob, plos;
+    
+    ob = SPI_Read(nrf24, READ_REG + OBSERVE_TX);
+    ps->retx += (ob & OB_ARC_CNT);
+    
+    plos = (ob & OB_PLOS_CNT) >> 4;
+    if (plos != st->plos) {
+        // 4-bit counter, below the last one seen: restarted on the chip
+        // (RF_CH write, brown-out), all of it new
+        ps->lost += (plos < st->plos) ? plos : (plos - st->plos) & 0x0f;
+        st->plos = plos;
+        if (plos >= 8) {
+            nRF24L01_PlosReset(nrf24);  // far from saturating at 15
+            st->plos = 0;
+        }
+    }
+}
+
+//=============================================
+// clear all counters of the module
+//=============================================
+void rf24_stats_reset(int nrf24)
+{
+    memset(&rf24_stats[nrf24], 0, sizeof(rf24_stats_t));
+    rf24_stats[nrf24].lat_min = 0xffffffffUL;
+}
+
+//=============================================
+// module soft-reset / TX FIFO flushed: PLOS_CNT
+// resynced (RF_CH may not be rewritten)
+//=============================================
+void rf24_stats_flush(int nrf24)
+{
+    rf24_stats[nrf24].fl_cnt = 0;
+    rf24_stats[nrf24].plos = (SPI_Read(nrf24, READ_REG + OBSERVE_TX) & OB_PLOS_CNT) >> 4;
+}
+
+//=============================================
+// payload written to the TX FIFO
+//=============================================
+void rf24_stats_tx(int nrf24, unsigned char pipe, unsigned char len)
+{
+    rf24_stats_t *st = &rf24_stats[nrf24];
+    
+    st->pipe[pipe].tx++;
+    if (st->fl_cnt < 3) {
+        st->fl_pipe[st->fl_cnt] = pipe;
+        st->fl_len[st->fl_cnt] = len;
+        st->fl_ts[st->fl_cnt] = get_stamp();
+        st->fl_cnt++;
+    }
+}
+
+//=============================================
+// oldest payload on air finished
+//=============================================
+void rf24_stats_tx_done(int nrf24, int result)
+{
+    rf24_stats_t *st = &rf24_stats[nrf24];
+    rf24_pipe_stats_t *ps;
+    unsigned char len;
+    unsigned long end, dt;
+    int i, lat = 1;
+    
+    if (!st->fl_cnt) return;
+    
+    ps = &st->pipe[st->fl_pipe[0]];
+    len = st->fl_len[0];
+    end = get_stamp();
+#ifdef RF24_IRQ
+    dt = rf24_irq_stamp(nrf24);         // TX_DS/MAX_RT edge, if one came since
+    if ((long)(dt - st->fl_ts[0]) > 0) {
+        end = dt;
+    } else {
+        lat = 0;    // TX_DS coalesced into the edge of the one before: time unknown
+    }
+#endif
+    dt = stamp_us(end - st->fl_ts[0]);
+    if (result == TX_OK) st->last_pipe = st->fl_pipe[0];
+    
+    st->fl_cnt--;
+    for (i = 0; i < st->fl_cnt; i++) {
+        st->fl_pipe[i] = st->fl_pipe[i + 1];
+        st->fl_len[i] = st->fl_len[i + 1];
+        st->fl_ts[i] = st->fl_ts[i + 1];
+    }
+    if (st->fl_cnt && (long)(end - st->fl_ts[0]) > 0) {
+        st->fl_ts[0] = end;             // next one on air from here
+    }
+    
+    switch (result) {
+    case TX_OK:
+        ps->ack++;
+        ps->tx_bytes += len;
+        if (lat) {
+            if (dt < st->lat_min) st->lat_min = dt;
+            if (dt > st->lat_max) st->lat_max = dt;
+            if ((st->lat_sum + dt) < st->lat_sum) {
+                st->lat_sum >>= 1;      // keep the average, drop the weight
+                st->lat_cnt >>= 1;
+            }
+            st->lat_sum += dt;
+            st->lat_cnt++;
+            st->lat_hist[lat_bin(dt)]++;
+        }
+#ifdef AUTO_ACK
+        stats_observe(nrf24, ps);
+#endif
+        break;
+        
+    case TX_MAX_RT:
+        ps->max_rt++;
+        stats_observe(nrf24, ps);
+        break;
+        
+    default:    // TX_FLUSHED: never on air, only 'tx' counted
+        break;
+    }
+}
+
+//=============================================
+// ACK payload received (PTX) / loaded (PRX)
+//=============================================
+void rf24_stats_ack_pl(int nrf24, unsigned char pipe, unsigned char len)
+{
+    if (pipe == STATS_LAST_TX) pipe = rf24_stats[nrf24].last_pipe;
+    rf24_stats[nrf24].pipe[pipe].ack_pl_bytes += len;
+}
+
+//=============================================
+// packet received
+//=============================================
+void rf24_stats_rx(int nrf24, unsigned char pipe, unsigned char len)
+{
+    rf24_stats[nrf24].pipe[pipe].rx++;
+    rf24_stats[nrf24].pipe[pipe].rx_bytes += len;
+}
+
+//=============================================
+// average TX-to-ACK latency
+//=============================================
+unsigned long rf24_stats_lat_avg(int nrf24)
+{
+    rf24_stats_t *st = &rf24_stats[nrf24];
+    
+    return st->lat_cnt ? st->lat_sum / st->lat_cnt : 0;
+}
+
+#endif // RF24_STATS
@@ -0,0 +1,113 @@
+// #################################################################
+//
+// RF24 Per Pipe Statistics Headfile
+//
+// 32-bit counters per module (A/B) and pipe (0~5), fed by the
+// application on each TX queued/finished and RX packet. PTX:
+// 'pipe' is the destination pipe (TX_ADDR) of the payload.
+// OBSERVE_TX is harvested when a payload finishes:
+// - ARC_CNT: retransmits, exact when one payload is on air at a
+//   time; in TX_STREAM mode the next payload may have started
+//   already (ARC_CNT restarts), so retx is a lower bound
+// - PLOS_CNT: lost packets, restarted (RF_CH rewrite) before
+//   it saturates at 15
+// TX-to-ACK latency: from the payload reaching the TX FIFO head (CE
+// rise or the completion of the one before) to its TX_DS edge
+// (RF24_IRQ: RF24_isr stamp, a TX_DS w/o an edge of its own not
+// sampled; else when retired)
+//
+// #################################################################
+#ifndef _RF24_STATS_H_
+#define _RF24_STATS_H_
+
+#include "../device_lib/rf24_lib.h"
+
+#define RF24_LAT_BINS   16  // latency histogram (usec), bin 0: 0, bin n: 2^(n-1) ~ 2^n-1, last: rest
+
+//***************************************************
+//
+// Counters of one pipe
+//
+//***************************************************
+typedef struct {
+    unsigned long tx;           // payloads written to TX FIFO
+    unsigned long ack;          // sent (TX_DS, ACKed under Auto.Ack)
+    unsigned long max_rt;       // dropped on MAX_RT
+    unsigned long retx;         // retransmits (ARC_CNT)
+    unsigned long lost;         // lost packets (PLOS_CNT)
+    unsigned long tx_bytes;     // payload bytes of 'ack'
+    unsigned long ack_pl_bytes; // PTX: ACK payload bytes received, PRX: loaded
+    unsigned long rx;           // packets received
+    unsigned long rx_bytes;     // payload bytes of 'rx'
+} rf24_pipe_stats_t;
+
+//***************************************************
+//
+// Statistics of one module
+//
+//***************************************************
+typedef struct {
+    rf24_pipe_stats_t pipe[6];
+    // TX-to-ACK latency (payload at TX FIFO head -> TX_DS) in usec
+    unsigned long lat_min;
+    unsigned long lat_max;
+    unsigned long lat_sum;      // average = lat_sum / lat_cnt (both halved before overflow)
+    unsigned long lat_cnt;
+    unsigned int  lat_hist[RF24_LAT_BINS];
+    // internal: PLOS_CNT last seen, payloads on air (oldest first)
+    unsigned char plos;
+    unsigned char fl_cnt;
+    unsigned char fl_pipe[3];
+    unsigned char fl_len[3];
+    unsigned long fl_ts[3];     // get_stamp() when queued, head: when on air
+    unsigned char last_pipe;    // pipe of the last TX_OK (ACK payload owner)
+} rf24_stats_t;
+
+extern rf24_stats_t rf24_stats[2];      // RF24 A/B
+
+// clear all counters of the module
+void rf24_stats_reset(int nrf24);
+
+// module soft-reset / TX FIFO flushed: payloads on air dropped uncounted,
+// PLOS_CNT taken as the chip holds it now
+void rf24_stats_flush(int nrf24);
+
+// payload of len bytes written to the TX FIFO for pipe
+void rf24_stats_tx(int nrf24, unsigned char pipe, unsigned char len);
+
+// oldest payload on air finished, result: TX_OK/TX_MAX_RT/TX_FLUSHED
+void rf24_stats_tx_done(int nrf24, int result);
+
+// ACK payload of len bytes received (PTX) / loaded for pipe (PRX),
+// pipe STATS_LAST_TX: pipe of the last TX_OK (the ACK it came with)
+#define STATS_LAST_TX   0xff
+void rf24_stats_ack_pl(int nrf24, unsigned char pipe, unsigned char len);
+
+// packet of len bytes received on pipe
+void rf24_stats_rx(int nrf24, unsigned char pipe, unsigned char len);
+
+// average TX-to-ACK latency in usec
+unsigned long rf24_stats_lat_avg(int nrf24);
+
+//***************************************************
+//
+// Application hooks, compiled out w/o RF24_STATS
+//
+//***************************************************
+#ifdef RF24_STATS
+ #define STATS_RESET(n)          rf24_stats_reset(n)
+ #define STATS_FLUSH(n)          rf24_stats_flush(n)
+ #define STATS_TX(n, p, l)       rf24_stats_tx(n, p, l)
+ #define STATS_TX_DONE(n, r)     rf24_stats_tx_done(n, r)
+ #define STATS_ACK_PL(n, p, l)   rf24_stats_ack_pl(n, p, l)
+ #define STATS_RX(n, p, l)       rf24_stats_rx(n, p, l)
+#else
+ #define STATS_RESET(n)
+ #define STATS_FLUSH(n)
+ #define STATS_TX(n, p, l)
+ #define STATS_TX_DONE(n, r)
+ #define STATS_ACK_PL(n, p, l)
+ #define STATS_RX(n, p, l)
+#endif
+
+#endif // _RF24_STATS_H_
@@ -0,0 +1,176 @@
+// #################################################################
+//
+// RF24 Run-time Transport Routines (RF24_XPORT)
+//
+// rf24_xp[] starts on the SPI ports w/ the IRQ pin (if RF24_IRQ),
+// as the image w/o RF24_XPORT would run, until rf24_xport_init()
+// or rf24_xport_auto() moves a module.
+//
+// #################################################################
+#include "../device_lib/rf24_if_cfg.h"  // interfaced with SPI or GPIO ports
+
+#ifdef RF24_XPORT
+
+#include <msp430f149.h>
+#include "../device_lib/rf24_lib.h"
+#include "../device_lib/timer_lib.h"
+
+//=============================================
+// CE/CSN of RF24 A/B (same pins on either port)
+//=============================================
+static void ce_a(unsigned char on)  { on ? RF24L01_A_CE_1 : RF24L01_A_CE_0; }
+static void ce_b(unsigned char on)  { on ? RF24L01_B_CE_1 : RF24L01_B_CE_0; }
+static void csn_a(unsigned char on) { on ? RF24L01_A_CSN_1 : RF24L01_A_CSN_0; }
+static void csn_b(unsigned char on) { on ? RF24L01_B_CSN_1 : RF24L01_B_CSN_0; }
+
+//=============================================
+// no IRQ pin used: STATUS read on every check
+//=============================================
+static int irq_poll(int nrf24)
+{
+    return 1;
+}
+
+#ifdef RF24_IRQ
+ #define IRQ_DFLT   is_rf24_irq
+ #define XP_DFLT    RF24_XP_IRQ
+#else
+ #define IRQ_DFLT   irq_poll
+ #define XP_DFLT    RF24_XP_POLL
+#endif
+
+rf24_xport_t rf24_xp[2] = {
+    { spi1_xfer, spi1_xfer_sg, ce_a, csn_a, IRQ_DFLT, RF24_BUS_SPI, XP_DFLT },    // RF24 A
+    { spi0_xfer, spi0_xfer_sg, ce_b, csn_b, IRQ_DFLT, RF24_BUS_SPI, XP_DFLT },    // RF24 B
+};
+
+/**************************************************
+Function: rf24_xport_init();
+
+Description:
+  Move module 'nrf24' to port 'bus' (RF24_BUS_SPI/GPIO):
+  SCK/MOSI/MISO handed to the USART or to GPIO, CSN left
+  high. 'irq' RF24_XP_IRQ checks the IRQ pin edge (w/o
+  RF24_IRQ: polled anyway), RF24_XP_POLL reads STATUS on
+  every check (IRQ pin, if armed, still wakes LPM0).
+
+  No transaction of the module may be in flight.
+
+input:
+  nrf24: nRF24L01P module - 0/1: A/B
+
+ **************************************************
+ */
+void rf24_xport_init(int nrf24, unsigned char bus, unsigned char irq)
+{
+    rf24_xport_t *x = &rf24_xp[nrf24];
+
+    if (bus == RF24_BUS_GPIO) {
+        nrf24 ? init_rf24_gpio_B() : init_rf24_gpio_A();
+        x->xfer = nrf24 ? gpio_b_xfer : gpio_a_xfer;
+        x->xfer_sg = nrf24 ? gpio_b_xfer_sg : gpio_a_xfer_sg;
+    } else {
+        bus = RF24_BUS_SPI;
+        nrf24 ? init_spi_B_master() : init_spi_A_master();
+        x->xfer = nrf24 ? spi0_xfer : spi1_xfer;
+        x->xfer_sg = nrf24 ? spi0_xfer_sg : spi1_xfer_sg;
+    }
+    x->bus = bus;
+
+#ifdef RF24_IRQ
+    x->irq = irq;
+    x->irq_pending = (irq == RF24_XP_IRQ) ? is_rf24_irq : irq_poll;
+#else
+    x->irq = RF24_XP_POLL;
+    x->irq_pending = irq_poll;
+#endif
+    x->csn(1);
+}
+
+//=============================================
+// one transaction on the current port of the
+// module, no register cache (rf24_lib.c)
+//=============================================
+static unsigned char xp_xact(rf24_xport_t *x, unsigned char cmd, unsigned char *tx, unsigned char *rx, unsigned char len)
+{
+    unsigned char status;
+
+    x->csn(0);
+    status = x->xfer(cmd, tx, rx, len);
+    x->csn(1);
+    return (status);
+}
+
+#define XP_ADR_WIDTH    5       // TX_ADDR bytes clocked per probe
+
+// TX_ADDR written w/ a pattern & read back, 1: same (3 bytes
+// compared, the shortest address width SETUP_AW allows)
+static int xp_probe(rf24_xport_t *x, unsigned char seed)
+{
+    unsigned char pat[XP_ADR_WIDTH], back[XP_ADR_WIDTH];
+    unsigned char i;
+
+    for (i = 0; i < XP_ADR_WIDTH; i++) {
+        pat[i] = seed + i * 0x35;
+    }
+    xp_xact(x, WRITE_REG + TX_ADDR, pat, 0, XP_ADR_WIDTH);
+    xp_xact(x, TX_ADDR, 0, back, XP_ADR_WIDTH);
+    for (i = 0; i < 3 && pat[i] == back[i]; i++);
+    return (i == 3);
+}
+
+/**************************************************
+Function: rf24_xport_auto();
+
+Description:
+  Auto-benchmark at startup: module 'nrf24' is probed on
+  each port for RF24_XP_BENCH (10ms, TX_ADDR write + read
+  back), the port w/ most good rounds is kept. A port w/
+  any bad read back (not wired, module not plugged) is
+  out. TX_ADDR is restored afterwards.
+
+  Needs Timer_A running (init_tm()), takes about 2 x
+  RF24_XP_BENCH.
+
+input:
+  nrf24: nRF24L01P module - 0/1: A/B
+  irq: RF24_XP_IRQ/POLL for the port kept
+
+return: RF24_BUS_xxx kept, RF24_BUS_NONE: no port answered
+        (module left on the SPI port)
+
+ **************************************************
+ */
+unsigned char rf24_xport_auto(int nrf24, unsigned char irq)
+{
+    static const unsigned char bus[] = { RF24_BUS_SPI, RF24_BUS_GPIO };
+    rf24_xport_t *x = &rf24_xp[nrf24];
+    unsigned char i, best = RF24_BUS_NONE;
+    unsigned char save[XP_ADR_WIDTH];
+    unsigned long t0;
+    unsigned int n, best_n = 0;
+
+    for (i = 0; i < sizeof(bus); i++) {
+        rf24_xport_init(nrf24, bus[i], irq);
+        xp_xact(x, TX_ADDR, 0, save, XP_ADR_WIDTH);
+
+        t0 = get_stamp();
+        for (n = 0; (get_stamp() - t0) < RF24_XP_BENCH; n++) {
+            if (!xp_probe(x, (unsigned char)n)) {
+                n = 0;                  // not working on this port
+                break;
+            }
+        }
+
+        xp_xact(x, WRITE_REG + TX_ADDR, save, 0, XP_ADR_WIDTH);
+        if (n > best_n) {
+            best_n = n;
+            best = bus[i];
+        }
+    }
+
+    rf24_xport_init(nrf24, (best == RF24_BUS_NONE) ? RF24_BUS_SPI : best, irq);
+    return (best);
+}
+
+#endif // RF24_XPORT
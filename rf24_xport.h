@@ -0,0 +1,60 @@
+// #################################################################
+//
+// RF24 Run-time Transport Headfile (RF24_XPORT)
+//
+// One descriptor per module holds the operations rf24_lib.c drives
+// the radio through: burst transaction (plain and gathered), CE, CSN
+// and the IRQ check.
+// SPI port (USART1 for A, USART0 for B) or GPIO bit-bang, IRQ pin or
+// STATUS polling, are chosen per module at init, e.g. A on USART1
+// w/ IRQ while B falls back to bit-banging. rf24_xport_auto() times
+// each port on the module and keeps the fastest one that works.
+//
+// CE/CSN/IRQ pins are the same for both ports (rf24_pins.h), only
+// SCK/MOSI/MISO move between the USART and GPIO (PxSEL).
+//
+// #################################################################
+#ifndef _RF24_XPORT_H_
+#define _RF24_XPORT_H_
+
+#include "../device_lib/rf24_if_cfg.h"
+#include "../device_lib/rf24_spi.h"
+#include "../device_lib/rf24_gpio.h"
+#include "../device_lib/timer_lib.h"
+
+#define RF24_BUS_SPI    0       // USART1 (A) / USART0 (B)
+#define RF24_BUS_GPIO   1       // bit-banged, rf24_gpio.c
+#define RF24_BUS_NONE   0xff    // rf24_xport_auto(): no port answered
+
+#define RF24_XP_POLL    0       // STATUS read on every check
+#define RF24_XP_IRQ     1       // STATUS read after an IRQ edge (RF24_IRQ only)
+
+#define RF24_XP_BENCH   (10*TA_PER_MS)   // get_stamp() counts per port timed by rf24_xport_auto()
+
+//***************************************************
+//
+// transport operations of one module
+//
+//***************************************************
+typedef struct {
+    // CSN already low: 'cmd' + 'len' data bytes, returns STATUS
+    unsigned char (*xfer)(unsigned char cmd, unsigned char *tx, unsigned char *rx, unsigned char len);
+    // CSN already low: 'cmd' + bytes gathered from 'nseg' segments
+    unsigned char (*xfer_sg)(unsigned char cmd, const rf24_seg_t *seg, int nseg);
+    void (*ce)(unsigned char on);       // CE pin 0/1
+    void (*csn)(unsigned char on);      // CSN pin 0/1
+    int  (*irq_pending)(int nrf24);     // 1: STATUS worth reading
+    unsigned char bus;                  // RF24_BUS_xxx
+    unsigned char irq;                  // RF24_XP_xxx
+} rf24_xport_t;
+
+extern rf24_xport_t rf24_xp[2];         // RF24 A/B, SPI port (IRQ if any) until set
+
+// select port 'bus' and IRQ mode 'irq' of module 'nrf24', pins claimed
+void rf24_xport_init(int nrf24, unsigned char bus, unsigned char irq);
+
+// time each port on module 'nrf24', keep the fastest working one,
+// returns RF24_BUS_xxx (NONE: left on the SPI port)
+unsigned char rf24_xport_auto(int nrf24, unsigned char irq);
+
+#endif // _RF24_XPORT_H_
@@ -0,0 +1,167 @@
+/*
+ * << MSP430 Cooperative Task Scheduler >>
+ *
+ * A round runs the tasks ready in priority order, ISRs may ready any
+ * task meanwhile (a higher one runs next). When no ready bit is left
+ * the round is over: the tasks returned w/ work left and the polled
+ * ones are readied for the next round, none of them: idle.
+ */
+
+// MSP430 family heads file
+#include <msp430f149.h>
+#include "../device_lib/sched_lib.h"
+#include "../device_lib/timer_lib.h"
+
+volatile unsigned char sched_rdy;       // ready bits, set by ISRs & main loop
+static unsigned char sched_again;       // returned w/ work left this round
+static unsigned char sched_poll;        // readied every round
+static sched_task_t sched_tab[SCHED_TASKS];
+
+#ifdef SCHED_STATS
+static unsigned long sched_t0;          // get_stamp() of sched_stats_reset()
+#endif
+
+// lowest bit set of a nibble (highest priority), O(1) pick
+static const unsigned char sched_lsb[16] = {
+    0, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0
+};
+
+// ---------------------------------------------
+//
+// no task, nothing ready
+//
+//----------------------------------------------
+void sched_init(void)
+{
+  unsigned char p;
+
+  sched_rdy = 0;
+  sched_again = 0;
+  sched_poll = 0;
+  for (p = 0; p < SCHED_TASKS; p++) {
+      sched_tab[p].fn = 0;
+  }
+#ifdef SCHED_STATS
+  sched_stats_reset();
+#endif
+}
+
+// ---------------------------------------------
+//
+// task 'fn' at level 'prio', ready at once
+//
+//----------------------------------------------
+void sched_add(unsigned char prio, sched_fn_t fn, unsigned char poll)
+{
+  if (prio >= SCHED_TASKS) return;
+
+  sched_tab[prio].fn = fn;
+  if (poll) sched_poll |= SCHED_BIT(prio);
+  sched_rdy |= SCHED_BIT(prio);
+}
+
+// ---------------------------------------------
+//
+// ready bits from main loop code (one BIS.B)
+//
+//----------------------------------------------
+void sched_ready(unsigned char bits)
+{
+  sched_rdy |= bits;
+}
+
+/**************************************************
+Function: sched_run();
+
+Description:
+  Dispatch the highest priority task ready: its bit is
+  cleared before it runs (an ISR readying it again runs
+  it once more), SCHED_AGAIN returned keeps it for the
+  next round. No bit left: a new round of the tasks w/
+  work left & the polled ones.
+
+return: 1: a task ran (or a round started), 0: idle
+
+ **************************************************
+ */
+int sched_run(void)
+{
+  unsigned char rdy = sched_rdy;
+  unsigned char p;
+  sched_task_t *t;
+#ifdef SCHED_STATS
+  unsigned long t0;
+#endif
+
+  if (rdy == 0) {
+      rdy = sched_again | sched_poll;
+      if (rdy == 0) return 0;       // idle
+      sched_again = 0;
+      sched_rdy |= rdy;
+  }
+
+  p = (rdy & 0x0f) ? sched_lsb[rdy & 0x0f] : 4 + sched_lsb[rdy >> 4];
+  sched_rdy &= ~SCHED_BIT(p);
+  t = &sched_tab[p];
+  if (t->fn == 0) return 1;
+
+#ifdef SCHED_STATS
+  t0 = get_stamp();
+#endif
+  if (t->fn() == SCHED_AGAIN) sched_again |= SCHED_BIT(p);
+#ifdef SCHED_STATS
+  t->cycles += get_stamp() - t0;
+  t->runs++;
+#endif
+  return 1;
+}
+
+// ---------------------------------------------
+//
+// any task to run ? (GIE off: no ISR readies
+// one between this check and LPM0)
+//
+//----------------------------------------------
+int sched_pending(void)
+{
+  return (sched_rdy | sched_again | sched_poll) ? 1 : 0;
+}
+
+#ifdef SCHED_STATS
+// ---------------------------------------------
+//
+// task statistics
+//
+//----------------------------------------------
+void sched_stats_reset(void)
+{
+  unsigned char p;
+
+  for (p = 0; p < SCHED_TASKS; p++) {
+      sched_tab[p].runs = 0;
+      sched_tab[p].cycles = 0;
+  }
+  sched_t0 = get_stamp();
+}
+
+sched_task_t *sched_task(unsigned char prio)
+{
+  return (prio < SCHED_TASKS) ? &sched_tab[prio] : 0;
+}
+
+unsigned long sched_span(void)
+{
+  return get_stamp() - sched_t0;
+}
+
+unsigned long sched_idle(void)
+{
+  unsigned long busy = 0;
+  unsigned char p;
+
+  for (p = 0; p < SCHED_TASKS; p++) {
+      busy += sched_tab[p].cycles;
+  }
+  return sched_span() - busy;
+}
+#endif // SCHED_STATS
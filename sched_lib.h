@@ -0,0 +1,84 @@
+/*
+ * << MSP430 Cooperative Task Scheduler >>
+ *
+ * Run-to-completion tasks on SCHED_TASKS priority levels (0: highest),
+ * one task per level. A task runs when its ready bit is set: from an
+ * ISR (SCHED_READY()), a deadline timer callback, or by itself when it
+ * returns w/ work left (SCHED_AGAIN). sched_run() dispatches the
+ * highest ready task, a higher one readied meanwhile goes next.
+ */
+#ifndef _SCHED_LIB_H_
+#define _SCHED_LIB_H_
+
+#ifndef SCHED_TASKS
+ #define SCHED_TASKS    8       // priority levels, ready bitmap width (<= 8)
+#endif
+
+#if (SCHED_TASKS > 8)
+ #error "SCHED_TASKS must fit the 8-bit ready bitmap"
+#endif
+
+#ifndef NO_SCHED_STATS
+ #define SCHED_STATS            // per task run count & cycles, 2 get_stamp() per run
+#endif
+
+#define SCHED_BIT(p)    (1 << (p))      // ready bit of priority 'p'
+
+// task return: SCHED_IDLE waits for its ready bit, SCHED_AGAIN runs it
+// again once the tasks ready now have run (work left, nothing to wait on)
+#define SCHED_IDLE      0
+#define SCHED_AGAIN     1
+
+typedef unsigned char (*sched_fn_t)(void);
+
+typedef struct {
+    sched_fn_t fn;              // 0: no task at this level
+#ifdef SCHED_STATS
+    unsigned long runs;         // times dispatched
+    unsigned long cycles;       // SMCLK counts spent (get_stamp() units)
+#endif
+} sched_task_t;
+
+// ready bits, bit p: task of priority p; one BIS.B/BIC.B per update,
+// set from ISRs w/o locking
+extern volatile unsigned char sched_rdy;
+
+// ready 'bits' (SCHED_BIT()s) from an ISR
+#define SCHED_READY(bits)   (sched_rdy |= (bits))
+
+//=======================================================================
+//
+//  << Public Functions Prototype >>
+//
+//=======================================================================
+
+// no task, nothing ready, statistics cleared
+void sched_init(void);
+
+// task 'fn' at priority 'prio', ready at once; 'poll' 1: no event readies
+// it, made ready again whenever the ready tasks all ran (polled device)
+void sched_add(unsigned char prio, sched_fn_t fn, unsigned char poll);
+
+// ready 'bits' (SCHED_BIT()s), main loop or timer callback context
+void sched_ready(unsigned char bits);
+
+// run the highest ready task, 0: none ready (idle)
+int sched_run(void);
+
+// any task ready ? call w/ GIE off before LPM (1/0)
+int sched_pending(void);
+
+#ifdef SCHED_STATS
+// clear run counts & cycles, start a new measuring span
+void sched_stats_reset(void);
+
+// task of priority 'prio' w/ its statistics
+sched_task_t *sched_task(unsigned char prio);
+
+// SMCLK counts since sched_stats_reset(), the part spent outside tasks
+// (timer wheel, LPM0, dispatch) is the idle time
+unsigned long sched_span(void);
+unsigned long sched_idle(void);
+#endif
+
+#endif // _SCHED_LIB_H_
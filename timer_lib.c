@@ -8,7 +8,31 @@
 #include <msp430f149.h>
 #include "timer_lib.h"
 
-unsigned int tm[TM_MAX]; // timer counter accumulated on TA0 interrupt
+unsigned int tm[TM_MAX]; // tick when reset_tm() (elapsed = tick - tm[])
+volatile unsigned int tm_tick;      // free running TA0 interrupt count
+volatile unsigned int tm_tick_hi;   // get_tick32() upper word
+volatile unsigned int tm_ovf;  // TAR overflow count, get_stamp() upper word
+volatile unsigned int tm_step = 1;  // ticks counted on next CCR0 (> 1: tickless idle)
+volatile unsigned char tm_sleep;    // CPU in LPM0 waiting for CCR0 (tm_idle()/delay_ms())
+
+//---------------------------------------------------------------
+// Deadline timer wheel: timer due at tick t is linked on slot 
+// t % TW_SLOTS; tm_run() visits the slots of the ticks elapsed 
+// since its last call and fires the timers due. Only main loop 
+// code touches the wheel, the TA0 ISR only counts the tick.
+//---------------------------------------------------------------
+#define TW_SLOTS    16          // power of 2
+static tm_timer_t *tw_slot[TW_SLOTS];
+static unsigned long tw_now;    // last tick visited by tm_run()
+
+// advance the tick count (IRQ context or GIE off)
+static void tm_tick_add(unsigned int n)
+{
+  unsigned int t = tm_tick;
+  
+  tm_tick = t + n;
+  if (tm_tick < t) tm_tick_hi++;
+}
 
 // ---------------------------------------
 // 
@@ -17,9 +41,7 @@ unsigned int tm[TM_MAX]; // timer counter accumulated on TA0 interrupt
 //----------------------------------------
 void reset_tm(unsigned int idx) {
   if (idx < TM_MAX) {
-      _BIC_SR(GIE);     /* Interrupts disabled */
-      tm[idx] = 0;      /* reset TM0 counter */
-      _BIS_SR(GIE);     /* Interrupts enabled */
+      tm[idx] = tm_tick;    /* one word write, no IRQ lock */
   }
 }
 
@@ -30,17 +52,219 @@ void reset_tm(unsigned int idx) {
 //----------------------------------------------
 unsigned int get_tm(unsigned int idx) {
   if (idx < TM_MAX) {
-      return tm[idx];      /* reset TM0 counter */
+      return tm_tick - tm[idx];
   } else {
       return 0;
   }
 }
 
+// ---------------------------------------------
+// 
+// Free running tick count (one word read, atomic)
+//
+//----------------------------------------------
+unsigned int get_tick(void) {
+  return tm_tick;
+}
+
+// ---------------------------------------------
+// 
+// Monotonic 32-bit tick count, upper word 
+// re-read if the tick wrapped meanwhile
+//
+//----------------------------------------------
+unsigned long get_tick32(void) {
+  unsigned int hi, lo;
+  
+  do {
+      hi = tm_tick_hi;
+      lo = tm_tick;
+  } while (hi != tm_tick_hi);
+  
+  return ((unsigned long)hi << 16) | lo;
+}
+
+// ---------------------------------------------
+// 
+// Deadline timers
+//
+//----------------------------------------------
+static void tw_link(tm_timer_t *t)
+{
+  tm_timer_t **slot = &tw_slot[t->due & (TW_SLOTS - 1)];
+  
+  t->next = *slot;
+  *slot = t;
+  t->state = TM_ARMED;
+}
+
+static void tw_unlink(tm_timer_t *t)
+{
+  tm_timer_t **pp = &tw_slot[t->due & (TW_SLOTS - 1)];
+  
+  while (*pp && *pp != t) pp = &(*pp)->next;
+  if (*pp) *pp = t->next;
+}
+
+// arm t to expire 'ticks' from now (>= 1), then every 'period' ticks
+// (0: one-shot); restarting an armed timer moves its deadline
+void tm_start(tm_timer_t *t, unsigned int ticks, unsigned int period, void (*fn)(tm_timer_t *t))
+{
+  if (t->state == TM_ARMED) tw_unlink(t);
+  if (ticks == 0) ticks = 1;
+  
+  t->due = get_tick32() + ticks;
+  t->period = period;
+  t->fn = fn;
+  tw_link(t);
+}
+
+// disarm t (no expiry)
+void tm_stop(tm_timer_t *t)
+{
+  if (t->state == TM_ARMED) tw_unlink(t);
+  t->state = TM_IDLE;
+}
+
+// one-shot t ran out and was not restarted since
+int tm_expired(tm_timer_t *t)
+{
+  return (t->state == TM_EXPIRED);
+}
+
+// fire timers due up to the current tick, call from the main loop
+void tm_run(void)
+{
+  unsigned long now = get_tick32();
+  tm_timer_t **pp, *t;
+  
+  SIM_CYCLES(16);           // tick read & compare, once per main loop pass
+  // late by more than a wheel turn: one pass over all slots does
+  if ((long)(now - tw_now) > TW_SLOTS) tw_now = now - TW_SLOTS;
+  
+  while (tw_now != now) {
+      tw_now++;
+      pp = &tw_slot[tw_now & (TW_SLOTS - 1)];
+      while ((t = *pp) != 0) {
+          if ((long)(t->due - tw_now) > 0) {      // later wheel turn
+              pp = &t->next;
+              continue;
+          }
+          *pp = t->next;
+          if (t->period) {
+              do {
+                  t->due += t->period;                // missed periods skipped
+              } while ((long)(t->due - now) <= 0);
+              tw_link(t);
+          } else {
+              t->state = TM_EXPIRED;
+          }
+          if (t->fn) t->fn(t);
+          
+          // callback may have (re)started/stopped timers: rescan the slot
+          pp = &tw_slot[tw_now & (TW_SLOTS - 1)];
+      }
+  }
+}
+
+// ---------------------------------------------
+// 
+// Tickless idle: sleep in LPM0 w/ CCR0 programmed to the next
+// deadline (<= TM_IDLE_MAX ticks) instead of the next 1ms tick.
+// Called w/ GIE off, after checking nothing is pending; returns 
+// w/ GIE on, after any interrupt that woke the CPU (RF24 IRQ, 
+// button edge) or the deadline. An early wake counts the ticks 
+// elapsed so far and goes back to ticking every 1ms.
+//
+//----------------------------------------------
+void tm_idle(void)
+{
+  unsigned long now = get_tick32();
+  unsigned int n = TM_IDLE_MAX, start, el, k;
+  tm_timer_t *t;
+  long d;
+  int i;
+  
+  for (i = 0; i < TW_SLOTS; i++) {
+      for (t = tw_slot[i]; t; t = t->next) {
+          d = (long)(t->due - now);
+          if (d < (long)n) n = (d > 0) ? (unsigned int)d : 0;
+      }
+  }
+  
+  // timer due or tick pending: no sleep, tm_run() first
+  if (n == 0 || (CCTL0 & CCIFG)) {
+      _BIS_SR(GIE);
+      return;
+  }
+  
+  if (n > 1) {
+      CCR0 += (n - 1) * CCR0_BASE;    // skip the ticks in between
+      tm_step = n;
+      if (CCTL0 & CCIFG) {
+          // old CCR0 matched before the write: that tick is 1, not n
+          CCR0 -= (n - 1) * CCR0_BASE;
+          tm_step = 1;
+          _BIS_SR(GIE);
+          return;
+      }
+  }
+  tm_sleep = 1;
+  _BIS_SR(LPM0_bits + GIE);           // wait for an interrupt
+  
+  _BIC_SR(GIE);
+  tm_sleep = 0;
+  if (tm_step > 1) {
+      // woken early: count whole ticks elapsed, next CCR0 on the 
+      // following tick unless that one is too close to reprogram
+      start = CCR0 - tm_step * CCR0_BASE;
+      el = TAR - start;
+      k = el / CCR0_BASE;
+      if (CCR0_BASE - (el - k * CCR0_BASE) < TM_IDLE_GUARD) k++;
+      if (k + 1 < tm_step) {
+          tm_tick_add(k);
+          CCR0 = start + (k + 1) * CCR0_BASE;
+          tm_step = 1;
+      }
+  }
+  _BIS_SR(GIE);
+}
+
+// ---------------------------------------------
+// 
+// High resolution time stamp (TAR + overflows)
+//
+// TAR wrapped but TAIFG not serviced yet (GIE off, ISR context) is
+// seen from TAIFG, only looked at within 4096 counts (5ms) of the 
+// wrap; overflow counted meanwhile: read again
+//----------------------------------------------
+unsigned long get_stamp(void) {
+  unsigned int hi, lo, pend;
+  
+  do {
+      hi = tm_ovf;
+      lo = TAR;
+      pend = (lo < 0x1000 && (TACTL & TAIFG)) ? 1 : 0;
+  } while (hi != tm_ovf);
+  
+  return ((unsigned long)(hi + pend) << 16) | lo;
+}
+
+// ---------------------------------------------
+// 
+// TAR counts to usec w/o 32-bit overflow
+//
+//----------------------------------------------
+unsigned long stamp_us(unsigned long dt) {
+  return (dt / TA_PER_MS) * 1000 + (unsigned int)(dt % TA_PER_MS) * 1000UL / TA_PER_MS;
+}
+
 //******************************************************************************************
 // Delay for about n operations
 //******************************************************************************************
 void inerDelay(unsigned int n)
 {
+    SIM_CYCLES(3UL * n);    // about 3 cycles per loop pass
     for (; n>0; n--);
 }
 
@@ -61,7 +285,15 @@ void delay_ms(unsigned int ms)
 
     while (elapse < end)
     {
-        inerDelay(100);  // sleep for a while
+        if (CCTL0 & CCIE) {
+            // TA0 ticking: LPM0 until the next tick
+            _BIC_SR(GIE);
+            tm_sleep = 1;
+            _BIS_SR(LPM0_bits + GIE);
+            tm_sleep = 0;
+        } else {
+            inerDelay(100);  // sleep for a while
+        }
         elapse = get_tm(TM_SYS);
     }
 }
@@ -75,7 +307,7 @@ void delay_ms(unsigned int ms)
 void init_tm(void)
 {
   CCTL0 = CCIE;               // CCR0 interrupt enabled
-  TACTL = TASSEL_2 + MC_2;    // SMCLK, contmode
+  TACTL = TASSEL_2 + MC_2 + TAIE;  // SMCLK, contmode, overflow IRQ for get_stamp()
   CCR0  = CCR0_BASE;
 
   _BIS_SR(GIE);               // Enter AM w/ interrupt
@@ -89,13 +321,30 @@ void init_tm(void)
 #pragma vector=TIMERA0_VECTOR
 __interrupt void Timer_A (void)
 {
-    int i;
-    
     CCR0 += CCR0_BASE;  // Reset CCR0 base
     
-    // increase all timers
-    for (i=0; i< TM_MAX; i++) {
-        tm[i]++;
+    // timers are deadlines against the tick (tm_run()/get_tm())
+    tm_tick_add(tm_step);
+    tm_step = 1;
+    
+    if (tm_sleep) {
+        _BIC_SR_IRQ(LPM0_bits);     // deadline/tick waited for: wake up
     }
 }
 
+//=====================================================================
+// 
+// Timer A1 interrupt service routine: TAR overflow (get_stamp())
+//
+//=====================================================================
+#pragma vector=TIMERA1_VECTOR
+__interrupt void Timer_A1 (void)
+{
+    switch (TAIV) {
+    case 10:        // TAIFG
+        tm_ovf++;
+        break;
+    default:        // CCR1/CCR2 unused
+        break;
+    }
+}
@@ -6,6 +6,13 @@
 
 #include <msp430f149.h>
 
+// CPU cycles of register-free code (RAM polls, delay loops) for the host
+// model, whose clock only runs on register access: host/msp430f149.h
+// maps it to sim_cycles(), nothing on the target
+#ifndef SIM_CYCLES
+ #define SIM_CYCLES(n)
+#endif
+
 //=======================================================================
 //
 // Timer Interrupt TA0 (10ms duration) Configuration:
@@ -26,6 +33,9 @@
  #define TM_TIME_MS  1    // TA0 ISR count per ms
 #endif
 #define TM_SEC      (1000/TM_TIME_MS)   // 1 second interrupt count  
+#define TA_PER_MS   (CCR0_BASE/TM_TIME_MS)  // TAR counts per msec (SMCLK)
+#define TM_IDLE_MAX (0xffff/CCR0_BASE - 1) // max. ticks skipped by tm_idle() (16-bit CCR0)
+#define TM_IDLE_GUARD 64                    // TAR counts needed to reprogram CCR0
 #define TM_SYS      0     // timer ID #0  // system timer
 #define TM_1        1     // timer ID #1  // else: application timers
 #define TM_2        2     // timer ID #2
@@ -39,15 +49,30 @@
 
 //-----------------------------------------------------------------------
 //
-// Application defined timer names
+// Application timeouts (tm_timer_t deadlines)
 //
 //-----------------------------------------------------------------------
-#define TM_TX       1     // timer ID #1
-#define TM_RX       2     // timer ID #2
-#define TM_RATE     3     // timer ID #3
 #define TX_TMOUT    (200/TM_TIME_MS)    // TX timeout in TA msec unit
 #define RX_TMOUT    (200/TM_TIME_MS)    // RX timeout in TA msec unit
 
+//=======================================================================
+//
+// Deadline timer, armed by tm_start(), fired by tm_run() in main loop
+// context: callback 'fn' (if any) called, one-shot left TM_EXPIRED
+//
+//=======================================================================
+#define TM_IDLE     0     // never started or stopped
+#define TM_ARMED    1     // linked on the timer wheel
+#define TM_EXPIRED  2     // one-shot ran out
+
+typedef struct tm_timer {
+    struct tm_timer *next;      // wheel slot chain
+    unsigned long due;          // expiry, get_tick32() value
+    unsigned int  period;       // re-arm period in ticks, 0: one-shot
+    void (*fn)(struct tm_timer *t);
+    unsigned char state;        // TM_IDLE/TM_ARMED/TM_EXPIRED
+} tm_timer_t;
+
 //=======================================================================
 //
 //  << Public Functions Prototype >>
@@ -63,10 +88,39 @@ void reset_tm(unsigned int idx);
 // Retrieve specified timer value (elapsed count) 
 unsigned int get_tm(unsigned int idx);
 
+// Free running TA0 tick count (TM_TIME_MS units, wraps at 65536)
+unsigned int get_tick(void);
+
+// Monotonic 32-bit TA0 tick count
+unsigned long get_tick32(void);
+
+// Arm deadline timer 'ticks' from now, then every 'period' (0: one-shot)
+void tm_start(tm_timer_t *t, unsigned int ticks, unsigned int period, void (*fn)(tm_timer_t *t));
+
+// Disarm deadline timer
+void tm_stop(tm_timer_t *t);
+
+// One-shot deadline passed (1/0)
+int tm_expired(tm_timer_t *t);
+
+// Fire the deadline timers due, call from the main loop
+void tm_run(void);
+
+// LPM0 until an interrupt or the next deadline timer, ticks suppressed;
+// call w/ GIE off once nothing is pending, returns w/ GIE on
+void tm_idle(void);
+
+// High resolution time stamp: TAR extended to 32 bits by TAIFG count
+// (SMCLK counts, TA_PER_MS per msec), callable from ISRs
+unsigned long get_stamp(void);
+
+// time stamp difference (TAR counts) in usec
+unsigned long stamp_us(unsigned long dt);
+
 // Delay for about n operations via looping
 void inerDelay(unsigned int n);
 
-// delay for desired msec with interrupt
+// delay for desired msec with interrupt (LPM0 between ticks)
 // input: ms must < 65535/TM_TIME_MS
 void delay_ms(unsigned int ms);
 